@@ -1,18 +1,58 @@
 #include "socket_manager.h"
 #include "sign.h"
+#include <cstdint>
+#include <cstring>
+
+int main(int argc, char** argv) {
+    // Select canvas backend (--offscreen runs without the LED hardware)
+    CanvasBackend backend = CanvasBackend::HARDWARE;
+    size_t font_budget_bytes = LedSignConstants::FONT_CACHE_BUDGET_BYTES;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--offscreen") == 0) {
+            backend = CanvasBackend::OFFSCREEN;
+        } else if (std::strcmp(argv[i], "--font-budget") == 0 && i + 1 < argc) {
+            // Memory cap for loaded fonts, in KiB
+            size_t kib;
+            if (!safeParseUInt(argv[++i], kib) || kib > SIZE_MAX / 1024) {
+                fprintf(stderr, "Invalid font budget: '%s' (expected KiB)\n", argv[i]);
+                return 2;
+            }
+            font_budget_bytes = kib * 1024;
+        } else {
+            fprintf(stderr, "Usage: %s [--offscreen] [--font-budget KiB]\n", argv[0]);
+            return 2;
+        }
+    }
 
-int main() {
     // Create sign instance
     Sign sign;
+    sign.font_budget_bytes = font_budget_bytes;
     
     // Initialize sign with error checking
-    SignError init_result = sign.Initialize();
+    SignError init_result = sign.Initialize(backend);
     if (init_result != SignError::SUCCESS) {
         fprintf(stderr, "Failed to initialize LED sign (error code: %d)\n", static_cast<int>(init_result));
         return static_cast<int>(init_result);
     }
     
     sign.clear();
+
+    // Local producers can push frames through shared memory; the sign works without it
+    if (!sign.openFrameRing()) {
+        fprintf(stderr, "Shared-memory frame ring disabled\n");
+    }
+
+    // Render thread lives for the whole daemon; scenes are swapped into it
+    sign.start();
+
+    // Templates are parsed once here or on upload, then shown by ID
+    sign.loadTemplates(LedSignConstants::TEMPLATES_PATH);
+
+    // Scheduled scenes fire from the daemon, whether or not the web app runs
+    sign.startScheduler(LedSignConstants::SCHEDULE_PATH);
+
+    // Scene rotation runs in the daemon, so switches need no client
+    sign.startPlaylist(LedSignConstants::PLAYLIST_PATH);
     
     // Run socket server
     int server_result = run_socket_server(sign);
@@ -0,0 +1,69 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include "sign.h"
+
+// Renders a scene into the offscreen backend and reports the per-frame cost
+// of Sign::renderFrame(). Frames are spaced --interval-us apart (not counted)
+// so animated objects actually move. Optionally dumps the final frame as a
+// PPM so frame output can be compared between builds.
+
+static const char* DEFAULT_CONFIG =
+    "STATIC;Hello World;0;10;(255,0,0);6x10;END;"
+    "SCROLL;Breaking News: the quick brown fox jumps over the lazy dog;26;(0,255,0);3000;6x10;END";
+
+int main(int argc, char** argv) {
+    int frames = 1000;
+    int interval_us = 1000;
+    std::string config = DEFAULT_CONFIG;
+    const char* dump_path = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--interval-us") == 0 && i + 1 < argc) {
+            interval_us = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            config = argv[++i];
+        } else if (std::strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+            dump_path = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--frames N] [--interval-us N] [--config CONFIG] [--dump out.ppm]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    Sign sign;
+    SignError init_result = sign.Initialize(CanvasBackend::OFFSCREEN);
+    if (init_result != SignError::SUCCESS) {
+        fprintf(stderr, "Failed to initialize offscreen sign (error code: %d)\n", static_cast<int>(init_result));
+        return static_cast<int>(init_result);
+    }
+
+    sign.setScene(parseSignConfig(config));
+    if (sign.renderables.empty()) {
+        fprintf(stderr, "Config produced no renderables\n");
+        return 1;
+    }
+
+    std::chrono::nanoseconds elapsed{0};
+    for (int i = 0; i < frames; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        sign.renderFrame();
+        elapsed += std::chrono::steady_clock::now() - start;
+        if (interval_us > 0) {
+            usleep(interval_us);
+        }
+    }
+
+    double per_frame_us = frames > 0 ? elapsed.count() / 1000.0 / frames : 0.0;
+    printf("%d frames, %zu renderables: %.2f us/frame\n", frames, sign.renderables.size(), per_frame_us);
+
+    if (dump_path && !sign.offscreen->WritePPM(dump_path)) {
+        return 1;
+    }
+    return 0;
+}
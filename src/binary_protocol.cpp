@@ -0,0 +1,201 @@
+#include "binary_protocol.h"
+
+#include <cstdio>
+
+namespace {
+
+/**
+ * Bounds-checked little-endian reader over a payload. Once a read runs past
+ * the end every further read fails, so callers can check once per item.
+ */
+struct PayloadReader {
+    std::string_view data;
+    size_t pos = 0;
+    bool ok = true;
+
+    bool has(size_t n) {
+        if (!ok || data.size() - pos < n) {
+            ok = false;
+        }
+        return ok;
+    }
+
+    uint8_t u8() {
+        return has(1) ? static_cast<uint8_t>(data[pos++]) : 0;
+    }
+
+    uint16_t u16() {
+        if (!has(2)) {
+            return 0;
+        }
+        uint16_t v = static_cast<uint8_t>(data[pos]) | (static_cast<uint8_t>(data[pos + 1]) << 8);
+        pos += 2;
+        return v;
+    }
+
+    std::string_view bytes(size_t n) {
+        if (!has(n)) {
+            return {};
+        }
+        std::string_view v = data.substr(pos, n);
+        pos += n;
+        return v;
+    }
+
+    bool done() const { return pos >= data.size(); }
+};
+
+void appendU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+    }
+}
+
+std::string fontOrDefault(std::string_view font) {
+    return font.empty() ? std::string("6x10") : std::string(font);
+}
+
+}
+
+bool decodeBinaryHeader(std::string_view data, BinaryHeader& header) {
+    if (data.size() < LedSignConstants::BINARY_HEADER_SIZE ||
+        static_cast<uint8_t>(data[0]) != LedSignConstants::BINARY_MAGIC) {
+        return false;
+    }
+
+    header.version = static_cast<uint8_t>(data[1]);
+    header.opcode = static_cast<BinaryOpcode>(data[2]);
+    header.flags = static_cast<uint8_t>(data[3]);
+    header.length = 0;
+    for (int i = 0; i < 4; ++i) {
+        header.length |= static_cast<uint32_t>(static_cast<uint8_t>(data[4 + i])) << (8 * i);
+    }
+    return true;
+}
+
+bool decodeScenePayload(std::string_view payload, Scene& scene) {
+    PayloadReader in{payload};
+    bool keyable = false; // The last item was a text object without a key yet
+
+    while (!in.done()) {
+        auto type = static_cast<SceneItemType>(in.u8());
+
+        if (type == SceneItemType::KEY) {
+            std::string_view key = in.bytes(in.u8());
+            if (!in.ok || key.empty() || key.find(';') != std::string_view::npos || !keyable) {
+                fprintf(stderr, "Invalid binary KEY item (expected a key without ';' right after a STATIC or SCROLL item)\n");
+                return false;
+            }
+            std::visit([key](Renderable &object) { object.key = std::string(key); }, scene.renderables.back());
+            keyable = false;
+            continue;
+        }
+        keyable = type == SceneItemType::STATIC || type == SceneItemType::SCROLL;
+
+        if (type == SceneItemType::FPS) {
+            uint16_t fps = in.u16();
+            if (!in.ok || fps < LedSignConstants::MIN_TARGET_FPS || fps > LedSignConstants::MAX_TARGET_FPS) {
+                fprintf(stderr, "Invalid binary FPS item (expected %d-%d)\n",
+                        LedSignConstants::MIN_TARGET_FPS, LedSignConstants::MAX_TARGET_FPS);
+                return false;
+            }
+            scene.target_fps = fps;
+
+        } else if (type == SceneItemType::STATIC) {
+            uint16_t x = in.u16();
+            uint16_t y = in.u16();
+            uint8_t r = in.u8(), g = in.u8(), b = in.u8();
+            std::string_view font = in.bytes(in.u8());
+            std::string_view text = in.bytes(in.u16());
+            if (!in.ok) {
+                fprintf(stderr, "Invalid binary scene: truncated STATIC item\n");
+                return false;
+            }
+            scene.renderables.emplace_back(std::in_place_type<TextObject>,
+                std::string(text), x, y, rgb_matrix::Color(r, g, b), fontOrDefault(font));
+
+        } else if (type == SceneItemType::SCROLL) {
+            uint16_t y = in.u16();
+            uint8_t r = in.u8(), g = in.u8(), b = in.u8();
+            uint16_t speed = in.u16();
+            uint8_t flags = in.u8();
+            std::string_view font = in.bytes(in.u8());
+            std::string_view text = in.bytes(in.u16());
+            if (!in.ok) {
+                fprintf(stderr, "Invalid binary scene: truncated SCROLL item\n");
+                return false;
+            }
+            scene.renderables.emplace_back(std::in_place_type<TextScrollingObject>,
+                std::string(text), y, speed, rgb_matrix::Color(r, g, b), fontOrDefault(font),
+                (flags & SCROLL_FLAG_DITHER) != 0);
+
+        } else {
+            fprintf(stderr, "Unknown binary scene item type: %u\n", static_cast<unsigned>(type));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool decodeFramePayload(BinaryOpcode opcode, std::string_view payload, size_t width, size_t height,
+                        std::vector<uint8_t>& rgb) {
+    PayloadReader in{payload};
+    uint16_t frame_width = in.u16();
+    uint16_t frame_height = in.u16();
+    if (!in.ok || frame_width != width || frame_height != height) {
+        fprintf(stderr, "Invalid frame: size %ux%u does not match display %zux%zu\n",
+                frame_width, frame_height, width, height);
+        return false;
+    }
+
+    const size_t size = width * height * 3;
+    if (opcode == BinaryOpcode::FRAME_RAW) {
+        std::string_view pixels = in.bytes(size);
+        if (!in.ok || !in.done()) {
+            fprintf(stderr, "Invalid raw frame: expected %zu bytes of pixel data\n", size);
+            return false;
+        }
+        rgb.assign(pixels.begin(), pixels.end());
+        return true;
+    }
+
+    rgb.clear();
+    rgb.reserve(size);
+    while (!in.done()) {
+        size_t count = static_cast<size_t>(in.u8()) + 1;
+        std::string_view color = in.bytes(3);
+        if (!in.ok || rgb.size() + count * 3 > size) {
+            fprintf(stderr, "Invalid RLE frame: run overflows the frame\n");
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            rgb.insert(rgb.end(), color.begin(), color.end());
+        }
+    }
+    if (rgb.size() != size) {
+        fprintf(stderr, "Invalid RLE frame: runs cover %zu of %zu pixels\n", rgb.size() / 3, width * height);
+        return false;
+    }
+    return true;
+}
+
+std::string encodeBinaryMessage(BinaryOpcode opcode, std::string_view payload) {
+    std::string out;
+    out.reserve(LedSignConstants::BINARY_HEADER_SIZE + payload.size());
+    out.push_back(static_cast<char>(LedSignConstants::BINARY_MAGIC));
+    out.push_back(static_cast<char>(LedSignConstants::BINARY_PROTOCOL_VERSION));
+    out.push_back(static_cast<char>(opcode));
+    out.push_back(0); // flags
+    appendU32(out, static_cast<uint32_t>(payload.size()));
+    out.append(payload);
+    return out;
+}
+
+std::string encodeBinaryReply(BinaryStatus status, std::string_view message) {
+    std::string payload;
+    payload.reserve(1 + message.size());
+    payload.push_back(static_cast<char>(status));
+    payload.append(message);
+    return encodeBinaryMessage(BinaryOpcode::REPLY, payload);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "parsecommand.h"
+
+/**
+ * Length-prefixed binary framing, accepted on the same socket as the text
+ * commands. Every message is an 8 byte header followed by the payload:
+ *
+ *   u8 magic (0xB5) | u8 version | u8 opcode | u8 flags | u32 LE payload length
+ *
+ * Replies use the same header with opcode REPLY and a payload of one status
+ * byte followed by a UTF-8 message.
+ *
+ * SET_SCENE payloads are a sequence of typed items, all integers little-endian:
+ *
+ *   STATIC: u8 type | u16 x | u16 y | u8 r,g,b | u8 font_len, font | u16 text_len, text
+ *   SCROLL: u8 type | u16 y | u8 r,g,b | u16 speed | u8 flags | u8 font_len, font | u16 text_len, text
+ *   FPS:    u8 type | u16 fps
+ *   KEY:    u8 type | u8 key_len, key
+ *
+ * An empty font name selects the default font. Text is length-prefixed, so it
+ * may contain ';' and newlines. A KEY item names the STATIC or SCROLL item
+ * right before it so PATCH can update that item, like TYPE#key in the text
+ * format; the key can't be empty or contain ';'.
+ *
+ * FRAME_RAW and FRAME_RLE payloads replace the scene with a full RGB frame of
+ * the display's size:
+ *
+ *   FRAME_RAW: u16 width | u16 height | width*height RGB triplets, row-major
+ *   FRAME_RLE: u16 width | u16 height | runs of (u8 count-1 | u8 r,g,b)
+ *
+ * Setting BINARY_FLAG_NO_REPLY in the header suppresses the reply, so a
+ * producer can stream consecutive frames without waiting for acks. Frames
+ * the render thread hasn't picked up yet are replaced by newer ones.
+ */
+enum class BinaryOpcode : uint8_t {
+    CLEAR = 0x01,
+    SET_SCENE = 0x02,
+    FRAME_RAW = 0x03,
+    FRAME_RLE = 0x04,
+    REPLY = 0x80
+};
+
+enum class BinaryStatus : uint8_t {
+    OK = 0,
+    BAD_REQUEST = 1,
+    UNSUPPORTED_VERSION = 2,
+    UNKNOWN_OPCODE = 3
+};
+
+enum class SceneItemType : uint8_t {
+    STATIC = 0x01,
+    SCROLL = 0x02,
+    FPS = 0x03,
+    KEY = 0x04
+};
+
+// Header flags
+constexpr uint8_t BINARY_FLAG_NO_REPLY = 0x01;
+
+// SCROLL item flags
+constexpr uint8_t SCROLL_FLAG_DITHER = 0x01;
+
+struct BinaryHeader {
+    uint8_t version = 0;
+    BinaryOpcode opcode = BinaryOpcode::CLEAR;
+    uint8_t flags = 0;
+    uint32_t length = 0;
+};
+
+/**
+ * Decode a message header.
+ * @param data At least BINARY_HEADER_SIZE bytes starting with the magic byte
+ * @param header Decoded header
+ * @return false if data is too short or doesn't start with the magic byte
+ */
+bool decodeBinaryHeader(std::string_view data, BinaryHeader& header);
+
+/**
+ * Decode a SET_SCENE payload into a scene.
+ * @param payload Message payload
+ * @param scene Scene to append the decoded items to
+ * @return false if the payload is truncated or holds an invalid item
+ */
+bool decodeScenePayload(std::string_view payload, Scene& scene);
+
+/**
+ * Decode a FRAME_RAW or FRAME_RLE payload into RGB pixels.
+ * @param opcode FRAME_RAW or FRAME_RLE
+ * @param payload Message payload
+ * @param width Expected frame width (the display width)
+ * @param height Expected frame height (the display height)
+ * @param rgb Receives width*height*3 bytes of row-major RGB
+ * @return false if the size doesn't match or the pixel data is malformed
+ */
+bool decodeFramePayload(BinaryOpcode opcode, std::string_view payload, size_t width, size_t height,
+                        std::vector<uint8_t>& rgb);
+
+/**
+ * Encode a message header followed by its payload.
+ */
+std::string encodeBinaryMessage(BinaryOpcode opcode, std::string_view payload);
+
+/**
+ * Encode a REPLY message.
+ */
+std::string encodeBinaryReply(BinaryStatus status, std::string_view message);
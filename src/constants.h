@@ -1,5 +1,7 @@
 #pragma once
 #include <sys/stat.h>
+#include <cstddef>
+#include <cstdint>
 
 namespace LedSignConstants {
     // LED Matrix Configuration
@@ -9,14 +11,34 @@ namespace LedSignConstants {
     constexpr int LED_PARALLEL = 1;
     constexpr const char* HARDWARE_MAPPING = "adafruit-hat";
     constexpr bool DISABLE_HARDWARE_PULSING = true;
+
+    // Pixel mapper chain applied on top of the panel chain (in order)
+    constexpr const char* PIXEL_MAPPER = "U-mapper";
+    constexpr const char* ROTATE_MAPPER = "Rotate";
+    constexpr const char* ROTATE_MAPPER_ANGLE = "180";
+    
+    // Font Configuration
+    constexpr const char* FONT_DIRECTORY = "./rpi-rgb-led-matrix/fonts/";
+    constexpr const char* DEFAULT_FONT = "6x10"; // Always kept loaded
+    constexpr size_t FONT_CACHE_BUDGET_BYTES = 2 * 1024 * 1024; // Loaded fonts beyond this are evicted LRU
+    constexpr const char* SCENE_FONTS_PATH = "./last_scene_fonts"; // Fonts the last scene used, pre-loaded at boot
+    constexpr const char* FONT_PACK_PATH = "./fonts.pack"; // Precompiled atlases, built by the fontpack tool
+    constexpr uint32_t FONT_PACK_VERSION = 1;
+
+    // Scheduler Configuration
+    constexpr const char* SCHEDULE_PATH = "./schedule"; // Scheduled scenes, one SCHEDULE ADD spec per line
+    constexpr const char* TEMPLATES_PATH = "./templates"; // Scene templates, one "<id> <config>" per line
+    constexpr const char* PLAYLIST_PATH = "./playlist"; // Scene rotation, one "<duration_ms> <fade_ms> <config>" per line
     
     // Display Configuration
     constexpr size_t DEFAULT_DISPLAY_WIDTH = 64;
     constexpr size_t DEFAULT_DISPLAY_HEIGHT = 32;
     
     // Animation Configuration
-    constexpr int TARGET_FPS = 60;
-    constexpr int FRAME_DELAY_MICROSECONDS = 16667; // ~60 FPS (16.67ms per frame)
+    constexpr int TARGET_FPS = 60; // Default frame rate for animated scenes
+    constexpr int MIN_TARGET_FPS = 1;
+    constexpr int MAX_TARGET_FPS = 240;
+    constexpr unsigned VSYNC_FRAMERATE_FRACTION = 1; // Swap on every panel refresh
     
     // Brightness limits
     constexpr int MIN_BRIGHTNESS = 1;
@@ -27,6 +49,20 @@ namespace LedSignConstants {
     constexpr int SOCKET_BACKLOG = 8;
     constexpr mode_t SOCKET_PERMISSIONS = 0700;
     constexpr size_t MAX_MESSAGE_SIZE = 64 * 1024; // 64KB sanity cap
+    constexpr size_t MAX_CLIENTS = 64; // Concurrent persistent connections
+    constexpr int EPOLL_MAX_EVENTS = 32;
+
+    // Binary protocol: a message starting with BINARY_MAGIC is a framed
+    // binary message rather than a text line (text commands are ASCII)
+    constexpr unsigned char BINARY_MAGIC = 0xB5;
+    constexpr unsigned char BINARY_PROTOCOL_VERSION = 1;
+    constexpr size_t BINARY_HEADER_SIZE = 8; // magic, version, opcode, flags, u32 LE payload length
+
+    // Shared-memory frame ring for local producers (see frame_ring.h)
+    constexpr const char* FRAME_RING_NAME = "/ledsign-frames";
+    constexpr uint32_t FRAME_RING_SLOTS = 3; // Producer writes one while the render thread reads another
+    constexpr uint32_t FRAME_RING_MAX_SLOTS = 8;
+    constexpr int FRAME_RING_WAIT_MS = 250; // Doorbell wait timeout so the watcher can notice shutdown
 }
 
 /**
@@ -41,4 +77,12 @@ enum class SignError {
     PIXEL_MAPPER_ERROR = 5,
     MATRIX_CREATION_ERROR = 6,
     PIXEL_MAPPER_APPLY_ERROR = 7
-};
\ No newline at end of file
+};
+
+/**
+ * Canvas backend the Sign renders into
+ */
+enum class CanvasBackend {
+    HARDWARE = 0,  // RGBMatrix driving the HAT
+    OFFSCREEN = 1  // In-memory framebuffer, no hardware required
+};
@@ -0,0 +1,128 @@
+#include "font_pack.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "constants.h"
+
+namespace {
+constexpr char FONT_PACK_MAGIC[8] = {'L', 'E', 'D', 'F', 'O', 'N', 'T', 'S'};
+
+size_t alignBlob(size_t offset) {
+    return (offset + 7) & ~static_cast<size_t>(7);
+}
+}
+
+bool FontPack::open(const std::string &path) {
+    mapping.reset();
+    mapped_size = 0;
+    entries.clear();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false; // No pack; fonts come from the .bdf files
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(FontPackHeader)) {
+        fprintf(stderr, "Font pack %s is too small\n", path.c_str());
+        close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void *memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+    std::shared_ptr<const uint8_t> mapped(static_cast<const uint8_t *>(memory),
+                                          [size](const uint8_t *p) { munmap(const_cast<uint8_t *>(p), size); });
+
+    const FontPackHeader *header = reinterpret_cast<const FontPackHeader *>(mapped.get());
+    if (std::memcmp(header->magic, FONT_PACK_MAGIC, sizeof(FONT_PACK_MAGIC)) != 0 ||
+        header->version != LedSignConstants::FONT_PACK_VERSION) {
+        fprintf(stderr, "Font pack %s has an unsupported format; rebuild it with fontpack\n", path.c_str());
+        return false;
+    }
+    if (header->font_count > (size - sizeof(FontPackHeader)) / sizeof(FontPackEntry)) {
+        fprintf(stderr, "Font pack %s is truncated\n", path.c_str());
+        return false;
+    }
+
+    const FontPackEntry *entry = reinterpret_cast<const FontPackEntry *>(mapped.get() + sizeof(FontPackHeader));
+    for (uint32_t i = 0; i < header->font_count; ++i, ++entry) {
+        if (entry->offset % 8 != 0 || entry->offset > size || entry->size > size - entry->offset ||
+            std::memchr(entry->name, '\0', sizeof(entry->name)) == nullptr) {
+            fprintf(stderr, "Font pack %s has a bad entry\n", path.c_str());
+            entries.clear();
+            return false;
+        }
+        entries[entry->name] = {static_cast<size_t>(entry->offset), static_cast<size_t>(entry->size)};
+    }
+
+    mapping = std::move(mapped);
+    mapped_size = size;
+    return true;
+}
+
+std::unique_ptr<GlyphAtlas> FontPack::atlas(const std::string &name) const {
+    auto it = entries.find(name);
+    if (it == entries.end()) {
+        return nullptr;
+    }
+    auto atlas = GlyphAtlas::FromBlob(mapping.get() + it->second.first, it->second.second, mapping);
+    if (!atlas) {
+        fprintf(stderr, "Font pack atlas for %s is corrupt\n", name.c_str());
+    }
+    return atlas;
+}
+
+bool FontPack::Write(const std::string &path, const std::vector<std::pair<std::string, const GlyphAtlas *>> &fonts) {
+    FontPackHeader header{};
+    std::memcpy(header.magic, FONT_PACK_MAGIC, sizeof(FONT_PACK_MAGIC));
+    header.version = LedSignConstants::FONT_PACK_VERSION;
+    header.font_count = static_cast<uint32_t>(fonts.size());
+
+    std::vector<FontPackEntry> index(fonts.size());
+    size_t offset = alignBlob(sizeof(FontPackHeader) + fonts.size() * sizeof(FontPackEntry));
+    for (size_t i = 0; i < fonts.size(); ++i) {
+        if (fonts[i].first.size() >= sizeof(index[i].name)) {
+            fprintf(stderr, "Font name too long for the pack: %s\n", fonts[i].first.c_str());
+            return false;
+        }
+        std::memcpy(index[i].name, fonts[i].first.c_str(), fonts[i].first.size() + 1);
+        index[i].offset = offset;
+        index[i].size = fonts[i].second->blobSize();
+        offset = alignBlob(offset + index[i].size);
+    }
+
+    const std::string temp_path = path + ".tmp";
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(FontPackEntry)));
+    for (size_t i = 0; i < fonts.size(); ++i) {
+        // Zero padding up to the entry's offset
+        static const char padding[8] = {};
+        out.write(padding, static_cast<std::streamsize>(index[i].offset - static_cast<size_t>(out.tellp())));
+        out.write(reinterpret_cast<const char *>(fonts[i].second->blob()), static_cast<std::streamsize>(index[i].size));
+    }
+    out.close();
+    if (!out) {
+        fprintf(stderr, "Failed to write %s\n", temp_path.c_str());
+        unlink(temp_path.c_str());
+        return false;
+    }
+    if (rename(temp_path.c_str(), path.c_str()) < 0) {
+        perror("rename");
+        unlink(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "glyph_atlas.h"
+
+// File layout: header, one entry per font, then the serialized atlases at
+// 8-byte aligned offsets. Fields use the byte order of the machine that
+// built the pack, which is the sign itself.
+struct FontPackHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t font_count;
+};
+
+struct FontPackEntry {
+    char name[48]; // NUL-terminated font name
+    uint64_t offset;
+    uint64_t size;
+};
+
+/**
+ * Glyph atlases of a whole font directory in one read-only mapped file.
+ *
+ * Atlases are used straight from the mapping, so loading a font from the pack
+ * costs no parsing and no heap memory, and the pages are shared with every
+ * other process mapping the same pack.
+ */
+struct FontPack {
+public:
+    /**
+     * Map a pack file and index its fonts. Replaces any pack opened before.
+     * @param path Pack written by Write()
+     * @return true if the pack is valid
+     */
+    bool open(const std::string &path);
+
+    bool isOpen() const { return mapping != nullptr; }
+    size_t fontCount() const { return entries.size(); }
+    bool contains(const std::string &name) const { return entries.count(name) != 0; }
+
+    /**
+     * Get a view of a font's atlas. The view keeps the mapping alive.
+     * @param name Font name (file name without .bdf)
+     * @return The atlas, or nullptr if the pack has no such font
+     */
+    std::unique_ptr<GlyphAtlas> atlas(const std::string &name) const;
+
+    /**
+     * Write a pack file. The file is replaced atomically so processes
+     * mapping the old pack keep a consistent view.
+     * @param path Output path
+     * @param fonts Font names and their atlases
+     * @return true on success
+     */
+    static bool Write(const std::string &path, const std::vector<std::pair<std::string, const GlyphAtlas *>> &fonts);
+
+private:
+    std::shared_ptr<const uint8_t> mapping;
+    size_t mapped_size = 0;
+    std::unordered_map<std::string, std::pair<size_t, size_t>> entries; // Name -> blob offset and size
+};
@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "constants.h"
+#include "font_pack.h"
+#include "glyph_atlas.h"
+#include "graphics.h"
+
+// Compiles every .bdf font in a directory into a font pack the sign maps at
+// startup instead of parsing the fonts. Rerun it whenever the fonts change.
+int main(int argc, char** argv) {
+    if (argc > 3) {
+        fprintf(stderr, "Usage: %s [font_dir] [output]\n", argv[0]);
+        return 2;
+    }
+    std::string font_dir = argc > 1 ? argv[1] : LedSignConstants::FONT_DIRECTORY;
+    std::string output = argc > 2 ? argv[2] : LedSignConstants::FONT_PACK_PATH;
+
+    std::vector<std::filesystem::path> files;
+    try {
+        for (const auto &entry : std::filesystem::directory_iterator(font_dir)) {
+            if (entry.path().extension() == ".bdf") {
+                files.push_back(entry.path());
+            }
+        }
+    } catch (const std::filesystem::filesystem_error& ex) {
+        fprintf(stderr, "Failed to read font directory %s: %s\n", font_dir.c_str(), ex.what());
+        return 1;
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<std::unique_ptr<GlyphAtlas>> atlases;
+    std::vector<std::pair<std::string, const GlyphAtlas *>> fonts;
+    size_t total = 0;
+    for (const auto &file : files) {
+        rgb_matrix::Font font;
+        if (!font.LoadFont(file.c_str())) {
+            fprintf(stderr, "Skipping %s: failed to load\n", file.c_str());
+            continue;
+        }
+        atlases.push_back(GlyphAtlas::FromFont(font));
+        fonts.emplace_back(file.stem().string(), atlases.back().get());
+        total += atlases.back()->blobSize();
+        printf("%-24s %5zu glyphs %8zu bytes\n", fonts.back().first.c_str(), atlases.back()->glyphCount(),
+               atlases.back()->blobSize());
+    }
+    if (fonts.empty()) {
+        fprintf(stderr, "No .bdf font files found in %s\n", font_dir.c_str());
+        return 1;
+    }
+
+    if (!FontPack::Write(output, fonts)) {
+        return 1;
+    }
+    printf("Wrote %zu fonts (%zu bytes of atlases) to %s\n", fonts.size(), total, output.c_str());
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "frame_buffer.h"
+#include "pixel_kernels.h"
+
+#include <algorithm>
+
+FrameBuffer::FrameBuffer(int width, int height)
+    : buffer_width(width), buffer_height(height),
+      pixels(static_cast<size_t>(width) * height * 3, 0) {}
+
+int FrameBuffer::width() const {
+    return buffer_width;
+}
+
+int FrameBuffer::height() const {
+    return buffer_height;
+}
+
+void FrameBuffer::SetPixel(int x, int y, uint8_t red, uint8_t green, uint8_t blue) {
+    if (x < 0 || y < 0 || x >= buffer_width || y >= buffer_height) {
+        return;
+    }
+    uint8_t *pixel = &pixels[(static_cast<size_t>(y) * buffer_width + x) * 3];
+    pixel[0] = red;
+    pixel[1] = green;
+    pixel[2] = blue;
+}
+
+void FrameBuffer::Clear() {
+    std::fill(pixels.begin(), pixels.end(), 0);
+}
+
+void FrameBuffer::Fill(uint8_t red, uint8_t green, uint8_t blue) {
+    fillPixels(pixels.data(), pixels.size() / 3, red, green, blue);
+}
+
+void FrameBuffer::FillRect(int x0, int y0, int x1, int y1, const rgb_matrix::Color &color) {
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, buffer_width);
+    y1 = std::min(y1, buffer_height);
+    for (int y = y0; y < y1; ++y) {
+        if (x0 < x1) {
+            fillPixels(row(y) + x0 * 3, x1 - x0, color.r, color.g, color.b);
+        }
+    }
+}
+
+void FrameBuffer::Blit(const uint8_t *rgb, int stride, int x0, int y0, int x1, int y1) {
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, buffer_width);
+    y1 = std::min(y1, buffer_height);
+    for (int y = y0; y < y1; ++y) {
+        if (x0 < x1) {
+            copyPixels(row(y) + x0 * 3, rgb + (static_cast<size_t>(y) * stride + x0) * 3, x1 - x0);
+        }
+    }
+}
+
+void FrameBuffer::DrawBits(const uint8_t *bits, size_t bits_stride, int bit_x, int x, int y, int columns, int rows,
+                           const rgb_matrix::Color &color) {
+    // Clip the bitmap window to the buffer
+    if (x < 0) {
+        columns += x;
+        bit_x -= x;
+        x = 0;
+    }
+    if (y < 0) {
+        rows += y;
+        bits += static_cast<size_t>(-y) * bits_stride;
+        y = 0;
+    }
+    columns = std::min(columns, buffer_width - x);
+    rows = std::min(rows, buffer_height - y);
+    if (columns <= 0 || rows <= 0) {
+        return;
+    }
+
+    for (int r = 0; r < rows; ++r) {
+        expandBitsToPixels(row(y + r) + x * 3, bits + r * bits_stride, bit_x, columns, color.r, color.g, color.b);
+    }
+}
+
+void FrameBuffer::Blend(const FrameBuffer &src, uint8_t alpha) {
+    if (src.pixels.size() != pixels.size()) {
+        return;
+    }
+    blendPixels(pixels.data(), src.pixels.data(), pixels.size() / 3, alpha);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "canvas.h"
+#include "graphics.h"
+
+/**
+ * Logical RGB888 framebuffer in display coordinates, row-major, 3 bytes per
+ * pixel. Frames are composed here with the pixel kernels and then pushed to
+ * the panel buffer, so only the push pays for per-pixel mapping.
+ */
+struct FrameBuffer : public rgb_matrix::Canvas {
+public:
+    FrameBuffer(int width, int height);
+
+    // rgb_matrix::Canvas interface
+    int width() const override;
+    int height() const override;
+    void SetPixel(int x, int y, uint8_t red, uint8_t green, uint8_t blue) override;
+    void Clear() override;
+    void Fill(uint8_t red, uint8_t green, uint8_t blue) override;
+
+    /**
+     * Fill a rectangle, clipped to the buffer. Edges are [x0, x1) x [y0, y1).
+     */
+    void FillRect(int x0, int y0, int x1, int y1, const rgb_matrix::Color &color);
+
+    /**
+     * Copy a rectangle of a row-major RGB image to the same coordinates here.
+     * @param rgb Source image, 3 bytes per pixel
+     * @param stride Source row length in pixels
+     */
+    void Blit(const uint8_t *rgb, int stride, int x0, int y0, int x1, int y1);
+
+    /**
+     * Draw the set bits of a 1-bit MSB-first bitmap in one color.
+     * @param bits First bitmap row
+     * @param bits_stride Bytes per bitmap row
+     * @param bit_x Bitmap column drawn at x
+     * @param x Buffer x of bitmap column bit_x
+     * @param y Buffer y of the first bitmap row
+     * @param columns Number of columns to draw
+     * @param rows Number of rows to draw
+     */
+    void DrawBits(const uint8_t *bits, size_t bits_stride, int bit_x, int x, int y, int columns, int rows,
+                  const rgb_matrix::Color &color);
+
+    /**
+     * Blend another buffer of the same size over this one.
+     * @param alpha Weight of src, 0 (keep this buffer) to 255 (replace with src)
+     */
+    void Blend(const FrameBuffer &src, uint8_t alpha);
+
+    const uint8_t *data() const { return pixels.data(); }
+    uint8_t *row(int y) { return &pixels[static_cast<size_t>(y) * buffer_width * 3]; }
+    const uint8_t *row(int y) const { return &pixels[static_cast<size_t>(y) * buffer_width * 3]; }
+
+private:
+    int buffer_width;
+    int buffer_height;
+    std::vector<uint8_t> pixels;
+};
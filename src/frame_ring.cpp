@@ -0,0 +1,220 @@
+#include "frame_ring.h"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <new>
+
+namespace {
+constexpr uint32_t FRAME_RING_MAGIC = 0x4C454446; // "LEDF"
+constexpr uint32_t FRAME_RING_VERSION = 1;
+
+// Slots start on a cache line boundary after the control block
+constexpr size_t slotsOffset() {
+    return (sizeof(FrameRingHeader) + 63) & ~static_cast<size_t>(63);
+}
+
+uint32_t *futexWord(std::atomic<uint32_t> &word) {
+    return reinterpret_cast<uint32_t *>(&word);
+}
+}
+
+FrameRing::~FrameRing() {
+    unmap();
+}
+
+void FrameRing::unmap() {
+    if (header) {
+        munmap(header, mapped_size);
+        header = nullptr;
+        slots = nullptr;
+    }
+    ring_width = ring_height = ring_slots = 0;
+    slot_size = 0;
+    if (owner) {
+        shm_unlink(shm_name.c_str());
+        owner = false;
+    }
+}
+
+bool FrameRing::create(const std::string &name, uint32_t width, uint32_t height, uint32_t slot_count) {
+    unmap();
+    if (slot_count < 2 || slot_count > LedSignConstants::FRAME_RING_MAX_SLOTS) {
+        fprintf(stderr, "Invalid frame ring slot count: %u (expected 2-%u)\n", slot_count,
+                LedSignConstants::FRAME_RING_MAX_SLOTS);
+        return false;
+    }
+
+    shm_unlink(name.c_str()); // Drop a ring left behind by a crashed daemon
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        perror("shm_open");
+        return false;
+    }
+
+    size_t frame_bytes = static_cast<size_t>(width) * height * 3;
+    mapped_size = slotsOffset() + frame_bytes * slot_count;
+    if (ftruncate(fd, static_cast<off_t>(mapped_size)) < 0) {
+        perror("ftruncate");
+        close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    void *memory = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        perror("mmap");
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    header = new (memory) FrameRingHeader{};
+    header->width = width;
+    header->height = height;
+    header->slot_count = slot_count;
+    header->latest.store(NO_FRAME, std::memory_order_relaxed);
+    header->version = FRAME_RING_VERSION;
+    // Magic last, so a producer never sees a half-initialized ring
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = FRAME_RING_MAGIC;
+
+    slots = static_cast<uint8_t *>(memory) + slotsOffset();
+    ring_width = width;
+    ring_height = height;
+    ring_slots = slot_count;
+    slot_size = frame_bytes;
+    shm_name = name;
+    owner = true;
+    return true;
+}
+
+bool FrameRing::open(const std::string &name) {
+    unmap();
+    int fd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("shm_open");
+        return false;
+    }
+
+    // Map the control block first to learn the ring's size
+    void *memory = mmap(nullptr, sizeof(FrameRingHeader), PROT_READ, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        perror("mmap");
+        close(fd);
+        return false;
+    }
+    const FrameRingHeader *probe = static_cast<const FrameRingHeader *>(memory);
+    bool valid = probe->magic == FRAME_RING_MAGIC && probe->version == FRAME_RING_VERSION &&
+                 probe->slot_count >= 2 && probe->slot_count <= LedSignConstants::FRAME_RING_MAX_SLOTS;
+    const uint32_t width = probe->width;
+    const uint32_t height = probe->height;
+    const uint32_t slot_count = probe->slot_count;
+    const size_t frame_bytes = static_cast<size_t>(width) * height * 3;
+    size_t size = slotsOffset() + frame_bytes * slot_count;
+    munmap(memory, sizeof(FrameRingHeader));
+    if (!valid) {
+        fprintf(stderr, "Frame ring %s has an unknown layout\n", name.c_str());
+        close(fd);
+        return false;
+    }
+
+    memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+
+    header = static_cast<FrameRingHeader *>(memory);
+    slots = static_cast<uint8_t *>(memory) + slotsOffset();
+    ring_width = width;
+    ring_height = height;
+    ring_slots = slot_count;
+    slot_size = frame_bytes;
+    mapped_size = size;
+    shm_name = name;
+
+    // Continue after the newest frame so the slot being displayed isn't reused first
+    uint32_t latest = header->latest.load(std::memory_order_acquire);
+    write_slot = latest < ring_slots ? (latest + 1) % ring_slots : 0;
+    return true;
+}
+
+uint8_t *FrameRing::beginWrite() {
+    if (!header) {
+        return nullptr;
+    }
+    // Odd sequence: readers of this slot will discard what they copied
+    header->sequence[write_slot].fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return slots + slot_size * write_slot;
+}
+
+void FrameRing::endWrite() {
+    if (!header) {
+        return;
+    }
+    header->sequence[write_slot].fetch_add(1, std::memory_order_release);
+    header->latest.store(write_slot, std::memory_order_release);
+    write_slot = (write_slot + 1) % ring_slots;
+
+    header->doorbell.fetch_add(1, std::memory_order_release);
+    syscall(SYS_futex, futexWord(header->doorbell), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+}
+
+const uint8_t *FrameRing::acquireLatest(uint32_t &slot, uint32_t &sequence) const {
+    if (!header) {
+        return nullptr;
+    }
+    if (!headerMatches()) {
+        return nullptr; // Resized or scribbled on behind our back
+    }
+    slot = header->latest.load(std::memory_order_acquire);
+    if (slot >= ring_slots) {
+        return nullptr;
+    }
+    sequence = header->sequence[slot].load(std::memory_order_acquire);
+    if (sequence & 1) {
+        return nullptr; // Lapped: the producer is already rewriting it
+    }
+    return slots + slot_size * slot;
+}
+
+bool FrameRing::validate(uint32_t slot, uint32_t sequence) const {
+    if (!header || slot >= ring_slots) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return header->sequence[slot].load(std::memory_order_relaxed) == sequence && headerMatches();
+}
+
+bool FrameRing::headerMatches() const {
+    return header->width == ring_width && header->height == ring_height && header->slot_count == ring_slots;
+}
+
+uint32_t FrameRing::doorbell() const {
+    return header ? header->doorbell.load(std::memory_order_acquire) : 0;
+}
+
+bool FrameRing::waitDoorbell(uint32_t seen, int timeout_ms) const {
+    if (!header) {
+        return false;
+    }
+    timespec timeout{timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+    // Shared (non-private) futex: the producer wakes us from another process
+    syscall(SYS_futex, futexWord(header->doorbell), FUTEX_WAIT, seen, &timeout, nullptr, 0);
+    return header->doorbell.load(std::memory_order_acquire) != seen;
+}
+
+void FrameRing::wake() {
+    if (header) {
+        syscall(SYS_futex, futexWord(header->doorbell), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+    }
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "constants.h"
+
+/**
+ * Control block at the start of the shared-memory frame ring. The slots
+ * follow it, each width*height*3 bytes of row-major RGB.
+ *
+ * Each slot is guarded by a seqlock: its sequence is odd while the producer
+ * writes it and even once the frame is complete. After a write the producer
+ * stores the slot in `latest` and increments `doorbell`, a futex word the
+ * daemon sleeps on.
+ */
+struct FrameRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t slot_count;
+    std::atomic<uint32_t> doorbell;
+    std::atomic<uint32_t> latest;
+    std::atomic<uint32_t> sequence[LedSignConstants::FRAME_RING_MAX_SLOTS];
+};
+
+/**
+ * POSIX shared-memory ring of frame slots.
+ *
+ * The daemon create()s the ring at startup. A local producer open()s it by
+ * name, fills beginWrite() with pixels and calls endWrite(); no bytes pass
+ * through the socket. The daemon reads the newest complete slot in place.
+ *
+ * Producer example:
+ *   FrameRing ring;
+ *   if (ring.open(LedSignConstants::FRAME_RING_NAME)) {
+ *       uint8_t *pixels = ring.beginWrite();
+ *       // ... fill ring.width() * ring.height() RGB pixels ...
+ *       ring.endWrite();
+ *   }
+ *
+ * Only one producer may write at a time.
+ */
+struct FrameRing {
+public:
+    static constexpr uint32_t NO_FRAME = UINT32_MAX;
+
+    FrameRing() = default;
+    ~FrameRing();
+    FrameRing(const FrameRing &) = delete;
+    FrameRing &operator=(const FrameRing &) = delete;
+
+    /**
+     * Create (or replace) the named ring. The name is unlinked again on destruction.
+     * @param name Shared memory object name, e.g. "/ledsign-frames"
+     * @param width Frame width in pixels
+     * @param height Frame height in pixels
+     * @param slot_count Number of frame slots (2 to FRAME_RING_MAX_SLOTS)
+     * @return true on success
+     */
+    bool create(const std::string &name, uint32_t width, uint32_t height, uint32_t slot_count);
+
+    /**
+     * Map an existing ring created by the daemon.
+     * @param name Shared memory object name
+     * @return true on success
+     */
+    bool open(const std::string &name);
+
+    // Geometry as of create() or open(), never re-read from the shared header
+    uint32_t width() const { return ring_width; }
+    uint32_t height() const { return ring_height; }
+
+    /**
+     * Producer: start writing the next frame.
+     * @return Slot pixels to fill, width*height*3 bytes
+     */
+    uint8_t *beginWrite();
+
+    /**
+     * Producer: publish the frame started by beginWrite() and ring the doorbell.
+     */
+    void endWrite();
+
+    /**
+     * Consumer: find the newest complete frame. The pixels may be overwritten
+     * while they're being read; check with validate() afterwards. Any process
+     * that maps the ring can write the header, so the slot is bounded by the
+     * ring's own geometry and no frame is returned once the header disagrees
+     * with it.
+     * @param slot Receives the slot index
+     * @param sequence Receives the slot's sequence at the start of the read
+     * @return Slot pixels, or nullptr if no frame has been published
+     */
+    const uint8_t *acquireLatest(uint32_t &slot, uint32_t &sequence) const;
+
+    /**
+     * Consumer: check that a slot wasn't rewritten since acquireLatest().
+     */
+    bool validate(uint32_t slot, uint32_t sequence) const;
+
+    /**
+     * Current doorbell value; changes whenever a frame is published.
+     */
+    uint32_t doorbell() const;
+
+    /**
+     * Sleep until the doorbell differs from seen or the timeout expires.
+     * @return true if the doorbell changed
+     */
+    bool waitDoorbell(uint32_t seen, int timeout_ms) const;
+
+    /**
+     * Wake every doorbell waiter without publishing a frame.
+     */
+    void wake();
+
+private:
+    void unmap();
+    bool headerMatches() const;
+
+    FrameRingHeader *header = nullptr;
+    uint8_t *slots = nullptr;
+    // Private copies of the header's geometry; the mapping was sized from these
+    uint32_t ring_width = 0;
+    uint32_t ring_height = 0;
+    uint32_t ring_slots = 0;
+    size_t slot_size = 0;
+    size_t mapped_size = 0;
+    std::string shm_name;
+    bool owner = false;
+    uint32_t write_slot = 0;
+};
@@ -0,0 +1,70 @@
+#include "frame_scheduler.h"
+#include <algorithm>
+#include <cerrno>
+
+namespace {
+
+constexpr long NANOSECONDS_PER_SECOND = 1000000000L;
+
+void addNanoseconds(timespec &ts, long ns) {
+    ts.tv_nsec += ns;
+    while (ts.tv_nsec >= NANOSECONDS_PER_SECOND) {
+        ts.tv_nsec -= NANOSECONDS_PER_SECOND;
+        ts.tv_sec++;
+    }
+}
+
+bool isBefore(const timespec &a, const timespec &b) {
+    return a.tv_sec < b.tv_sec || (a.tv_sec == b.tv_sec && a.tv_nsec < b.tv_nsec);
+}
+
+} // namespace
+
+FrameScheduler::FrameScheduler(int fps) {
+    setTargetFps(fps);
+    reset();
+}
+
+void FrameScheduler::setTargetFps(int fps) {
+    target_fps = std::clamp(fps, LedSignConstants::MIN_TARGET_FPS, LedSignConstants::MAX_TARGET_FPS);
+    period_ns = NANOSECONDS_PER_SECOND / target_fps;
+}
+
+int FrameScheduler::targetFps() const {
+    return target_fps;
+}
+
+void FrameScheduler::reset() {
+    clock_gettime(CLOCK_MONOTONIC, &next_deadline);
+    addNanoseconds(next_deadline, period_ns);
+}
+
+bool FrameScheduler::waitForNextFrame() {
+    frames++;
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    bool on_time = isBefore(now, next_deadline);
+    if (!on_time) {
+        // Overran: drop the missed slots and line up with the next future one
+        missed++;
+        while (!isBefore(now, next_deadline)) {
+            addNanoseconds(next_deadline, period_ns);
+        }
+    }
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_deadline, nullptr) == EINTR) {
+        // Interrupted by a signal - keep sleeping until the same deadline
+    }
+    addNanoseconds(next_deadline, period_ns);
+    return on_time;
+}
+
+uint64_t FrameScheduler::frameCount() const {
+    return frames;
+}
+
+uint64_t FrameScheduler::missedDeadlines() const {
+    return missed;
+}
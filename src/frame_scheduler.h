@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+
+#include "constants.h"
+
+/**
+ * Fixed-rate frame pacing against absolute deadlines.
+ *
+ * Deadlines are kept on CLOCK_MONOTONIC and advanced by exactly one period
+ * per frame, so render time does not accumulate into the frame period. When
+ * a frame overruns its deadline the scheduler skips ahead to the next future
+ * deadline instead of bursting frames to catch up.
+ */
+struct FrameScheduler {
+public:
+    /**
+     * @param fps Target frames per second (clamped to MIN_TARGET_FPS-MAX_TARGET_FPS)
+     */
+    explicit FrameScheduler(int fps = LedSignConstants::TARGET_FPS);
+
+    /**
+     * Change the target frame rate. Takes effect from the next deadline.
+     * @param fps Target frames per second
+     */
+    void setTargetFps(int fps);
+
+    int targetFps() const;
+
+    /**
+     * Restart pacing so the next deadline is one period from now.
+     */
+    void reset();
+
+    /**
+     * Sleep until the current frame deadline, then advance it by one period.
+     * If the deadline already passed, sleeps until the next future one instead.
+     * @return false if the deadline had already passed (a missed frame)
+     */
+    bool waitForNextFrame();
+
+    uint64_t frameCount() const;
+    uint64_t missedDeadlines() const;
+
+private:
+    int target_fps;
+    long period_ns;
+    timespec next_deadline{};
+    uint64_t frames = 0;
+    uint64_t missed = 0;
+};
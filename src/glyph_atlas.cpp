@@ -0,0 +1,204 @@
+#include "glyph_atlas.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr uint32_t REPLACEMENT_CODEPOINT = 0xFFFD;
+constexpr uint32_t LAST_ATLAS_CODEPOINT = 0xFFFF;
+
+// Start of a serialized atlas; followed by codepoints (u32 each), advances
+// (i16 each, padded to 4 bytes) and the glyph bitmaps
+struct AtlasBlobHeader {
+    uint32_t glyph_count;
+    int32_t height;
+    int32_t baseline;
+    int32_t cell_width;
+    uint32_t stride;
+    int32_t replacement;
+    int32_t latin1[256];
+};
+
+size_t advancesOffset(size_t glyph_count) {
+    return sizeof(AtlasBlobHeader) + glyph_count * sizeof(uint32_t);
+}
+
+size_t bitsOffset(size_t glyph_count) {
+    return (advancesOffset(glyph_count) + glyph_count * sizeof(int16_t) + 3) & ~static_cast<size_t>(3);
+}
+
+// Canvas that records the pixels DrawGlyph touches into one glyph cell, or
+// only measures how far right they reach while cell is null
+struct CaptureCanvas : public rgb_matrix::Canvas {
+    int canvas_width;
+    int canvas_height;
+    uint8_t *cell = nullptr;
+    size_t stride = 0;
+    int extent = 0;
+
+    CaptureCanvas(int width, int height) : canvas_width(width), canvas_height(height) {}
+
+    int width() const override { return canvas_width; }
+    int height() const override { return canvas_height; }
+
+    void SetPixel(int x, int y, uint8_t, uint8_t, uint8_t) override {
+        if (x < 0 || y < 0 || x >= canvas_width || y >= canvas_height) {
+            return;
+        }
+        extent = std::max(extent, x + 1);
+        if (cell) {
+            cell[y * stride + (x >> 3)] |= static_cast<uint8_t>(0x80 >> (x & 7));
+        }
+    }
+
+    void Clear() override {}
+    void Fill(uint8_t, uint8_t, uint8_t) override {}
+};
+
+int32_t lookup(const std::vector<uint32_t> &codepoints, uint32_t codepoint) {
+    auto it = std::lower_bound(codepoints.begin(), codepoints.end(), codepoint);
+    if (it != codepoints.end() && *it == codepoint) {
+        return static_cast<int32_t>(it - codepoints.begin());
+    }
+    return GlyphAtlas::NO_GLYPH;
+}
+}
+
+std::unique_ptr<GlyphAtlas> GlyphAtlas::FromFont(const rgb_matrix::Font &font) {
+    // The font has no glyph iterator, so probe the BMP for defined glyphs
+    std::vector<uint32_t> codepoints;
+    std::vector<int16_t> advances;
+    int max_advance = 0;
+    for (uint32_t cp = 0; cp <= LAST_ATLAS_CODEPOINT; ++cp) {
+        int width = font.CharacterWidth(cp);
+        if (width >= 0) {
+            codepoints.push_back(cp);
+            advances.push_back(static_cast<int16_t>(width));
+            max_advance = std::max(max_advance, width);
+        }
+    }
+
+    // Glyph bitmaps may reach past their advance, so size the cell from what
+    // they actually draw
+    const rgb_matrix::Color on(255, 255, 255);
+    CaptureCanvas canvas(2 * max_advance + 8, font.height());
+    for (uint32_t cp : codepoints) {
+        font.DrawGlyph(&canvas, 0, font.baseline(), on, nullptr, cp);
+    }
+
+    AtlasBlobHeader header{};
+    header.glyph_count = static_cast<uint32_t>(codepoints.size());
+    header.height = font.height();
+    header.baseline = font.baseline();
+    header.cell_width = std::max(max_advance, canvas.extent);
+    header.stride = (static_cast<uint32_t>(header.cell_width) + 7) / 8;
+    int32_t replacement = lookup(codepoints, REPLACEMENT_CODEPOINT);
+    header.replacement = replacement;
+    for (uint32_t cp = 0; cp < 256; ++cp) {
+        int32_t glyph = lookup(codepoints, cp);
+        header.latin1[cp] = glyph == NO_GLYPH ? replacement : glyph;
+    }
+
+    // Lay the blob out in place, then draw each glyph straight into its cell
+    const size_t glyph_size = static_cast<size_t>(header.stride) * header.height;
+    const size_t size = bitsOffset(codepoints.size()) + glyph_size * codepoints.size();
+    std::unique_ptr<GlyphAtlas> atlas(new GlyphAtlas());
+    atlas->owned.assign((size + 3) / 4, 0);
+    uint8_t *data = reinterpret_cast<uint8_t *>(atlas->owned.data());
+    std::memcpy(data, &header, sizeof(header));
+    std::memcpy(data + sizeof(header), codepoints.data(), codepoints.size() * sizeof(uint32_t));
+    std::memcpy(data + advancesOffset(codepoints.size()), advances.data(), advances.size() * sizeof(int16_t));
+
+    uint8_t *bits = data + bitsOffset(codepoints.size());
+    canvas.canvas_width = header.cell_width;
+    canvas.stride = header.stride;
+    for (size_t i = 0; i < codepoints.size(); ++i) {
+        canvas.cell = bits + i * glyph_size;
+        font.DrawGlyph(&canvas, 0, header.baseline, on, nullptr, codepoints[i]);
+    }
+
+    atlas->bind(data, size);
+    return atlas;
+}
+
+std::unique_ptr<GlyphAtlas> GlyphAtlas::FromBlob(const uint8_t *data, size_t size, std::shared_ptr<const void> backing) {
+    std::unique_ptr<GlyphAtlas> atlas(new GlyphAtlas());
+    if (reinterpret_cast<uintptr_t>(data) % 4 != 0 || !atlas->bind(data, size)) {
+        return nullptr;
+    }
+    atlas->backing = std::move(backing);
+    return atlas;
+}
+
+bool GlyphAtlas::bind(const uint8_t *data, size_t size) {
+    if (size < sizeof(AtlasBlobHeader)) {
+        return false;
+    }
+    const AtlasBlobHeader *header = reinterpret_cast<const AtlasBlobHeader *>(data);
+    if (header->height < 0 || header->cell_width < 0 || header->stride != (static_cast<uint32_t>(header->cell_width) + 7) / 8) {
+        return false;
+    }
+
+    // Sizes come from a file, so check them in 64 bits where they can't wrap
+    // on a 32-bit size_t; each step bounds the next product
+    const uint64_t blob_bytes = size;
+    const uint64_t glyphs = header->glyph_count;
+    const uint64_t bits_at = (sizeof(AtlasBlobHeader) + glyphs * (sizeof(uint32_t) + sizeof(int16_t)) + 3) & ~uint64_t{3};
+    const uint64_t glyph_bytes = static_cast<uint64_t>(header->stride) * static_cast<uint64_t>(header->height);
+    if (bits_at > blob_bytes || glyph_bytes > blob_bytes || glyph_bytes * glyphs > blob_bytes - bits_at) {
+        return false;
+    }
+    const size_t count = header->glyph_count;
+    if (header->replacement < NO_GLYPH || header->replacement >= static_cast<int32_t>(count)) {
+        return false;
+    }
+    for (int32_t glyph : header->latin1) {
+        if (glyph < NO_GLYPH || glyph >= static_cast<int32_t>(count)) {
+            return false;
+        }
+    }
+
+    font_height = header->height;
+    font_baseline = header->baseline;
+    cell_width = header->cell_width;
+    row_stride = header->stride;
+    glyph_count = count;
+    replacement = header->replacement;
+    latin1 = header->latin1;
+    codepoints = reinterpret_cast<const uint32_t *>(data + sizeof(AtlasBlobHeader));
+    advances = reinterpret_cast<const int16_t *>(data + advancesOffset(count));
+    bits = data + bitsOffset(count);
+    blob_data = data;
+    blob_size = size;
+    return true;
+}
+
+int GlyphAtlas::findGlyph(uint32_t codepoint) const {
+    const uint32_t *end = codepoints + glyph_count;
+    const uint32_t *it = std::lower_bound(codepoints, end, codepoint);
+    if (it != end && *it == codepoint) {
+        return static_cast<int>(it - codepoints);
+    }
+    return replacement;
+}
+
+size_t GlyphAtlas::memoryUsage() const {
+    return sizeof(GlyphAtlas) + owned.capacity() * sizeof(uint32_t);
+}
+
+void GlyphAtlas::DrawGlyph(rgb_matrix::Canvas *canvas, int x, int y, const rgb_matrix::Color &color, int glyph) const {
+    const uint8_t *row = glyphBits(glyph);
+    const int top = y - font_baseline;
+    for (int r = 0; r < font_height; ++r, row += row_stride) {
+        for (int col = 0; col < cell_width; ++col) {
+            uint8_t byte = row[col >> 3];
+            if (byte == 0) {
+                col |= 7; // Skip the rest of an empty byte
+                continue;
+            }
+            if (byte & (0x80 >> (col & 7))) {
+                canvas->SetPixel(x + col, top + r, color.r, color.g, color.b);
+            }
+        }
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "canvas.h"
+#include "graphics.h"
+
+/**
+ * A font converted into one contiguous block of 1-bit glyph bitmaps.
+ *
+ * Every glyph occupies height() rows of stride() bytes, packed MSB-first,
+ * with row baseline() on the text baseline, so drawing a glyph is a loop over
+ * packed bits instead of a glyph map lookup and a SetPixel per pixel.
+ * Latin-1 codepoints are resolved through a flat table; other codepoints by
+ * binary search. Missing glyphs resolve to the replacement character like
+ * rgb_matrix::DrawText does, or to nothing if the font has none.
+ *
+ * The atlas lives in a single serialized blob (see blob()), either owned or
+ * mapped from a font pack, so it can be written out and loaded without any
+ * parsing or copying.
+ */
+struct GlyphAtlas {
+public:
+    static constexpr int NO_GLYPH = -1;
+
+    /**
+     * Rasterize every glyph of a font in the Basic Multilingual Plane.
+     * @param font Loaded BDF font
+     * @return The atlas
+     */
+    static std::unique_ptr<GlyphAtlas> FromFont(const rgb_matrix::Font &font);
+
+    /**
+     * Use a serialized atlas in place.
+     * @param data Blob written from blob(), 4-byte aligned
+     * @param size Blob size in bytes
+     * @param backing Keeps the memory holding data alive (e.g. a pack mapping)
+     * @return The atlas, or nullptr if the blob is malformed
+     */
+    static std::unique_ptr<GlyphAtlas> FromBlob(const uint8_t *data, size_t size, std::shared_ptr<const void> backing);
+
+    int height() const { return font_height; }
+    int baseline() const { return font_baseline; }
+    int cellWidth() const { return cell_width; }
+    size_t stride() const { return row_stride; }
+    size_t glyphCount() const { return glyph_count; }
+
+    /**
+     * Glyph used to draw a codepoint, including the replacement fallback.
+     * @return Glyph index, or NO_GLYPH if nothing is drawn
+     */
+    int glyphIndex(uint32_t codepoint) const {
+        if (codepoint < 256) {
+            return latin1[codepoint];
+        }
+        return findGlyph(codepoint);
+    }
+
+    /**
+     * Pen advance for a codepoint, 0 if nothing is drawn.
+     */
+    int advance(uint32_t codepoint) const {
+        int glyph = glyphIndex(codepoint);
+        return glyph == NO_GLYPH ? 0 : advances[glyph];
+    }
+
+    int glyphAdvance(int glyph) const { return advances[glyph]; }
+
+    /**
+     * First row of a glyph's bitmap.
+     */
+    const uint8_t *glyphBits(int glyph) const { return bits + static_cast<size_t>(glyph) * font_height * row_stride; }
+
+    /**
+     * Approximate heap memory held by the atlas in bytes. Mapped atlases
+     * only count their bookkeeping; their pages are shared and reclaimable.
+     */
+    size_t memoryUsage() const;
+
+    /**
+     * The serialized atlas.
+     */
+    const uint8_t *blob() const { return blob_data; }
+    size_t blobSize() const { return blob_size; }
+
+    /**
+     * Draw a glyph through a generic canvas, one SetPixel per set bit.
+     * @param x Left edge of the glyph cell
+     * @param y Text baseline
+     */
+    void DrawGlyph(rgb_matrix::Canvas *canvas, int x, int y, const rgb_matrix::Color &color, int glyph) const;
+
+private:
+    GlyphAtlas() = default;
+    bool bind(const uint8_t *data, size_t size);
+    int findGlyph(uint32_t codepoint) const;
+
+    int font_height = 0;
+    int font_baseline = 0;
+    int cell_width = 0;
+    size_t row_stride = 0;
+    size_t glyph_count = 0;
+    int replacement = NO_GLYPH;
+
+    // Views into the blob
+    const int32_t *latin1 = nullptr;
+    const uint32_t *codepoints = nullptr; // Sorted; glyph i draws codepoints[i]
+    const int16_t *advances = nullptr;
+    const uint8_t *bits = nullptr;
+
+    const uint8_t *blob_data = nullptr;
+    size_t blob_size = 0;
+    std::vector<uint32_t> owned;         // Blob storage for atlases built from a font
+    std::shared_ptr<const void> backing; // Keeps a mapped blob alive
+};
@@ -0,0 +1,100 @@
+#include "offscreen_canvas.h"
+#include <algorithm>
+#include <cstdio>
+
+OffscreenCanvas::OffscreenCanvas(int physical_width, int physical_height)
+    : map(physical_width, physical_height),
+      framebuffer(static_cast<size_t>(physical_width) * physical_height * 3, 0) {}
+
+bool OffscreenCanvas::ApplyPixelMapper(const rgb_matrix::PixelMapper *mapper) {
+    return map.Apply(mapper);
+}
+
+int OffscreenCanvas::width() const {
+    return map.width();
+}
+
+int OffscreenCanvas::height() const {
+    return map.height();
+}
+
+void OffscreenCanvas::SetPixel(int x, int y, uint8_t red, uint8_t green, uint8_t blue) {
+    if (x < 0 || y < 0 || x >= map.width() || y >= map.height()) {
+        return;
+    }
+
+    uint32_t index = map.index(x, y);
+    if (index == PixelMap::UNMAPPED) {
+        return;
+    }
+    uint8_t *pixel = &framebuffer[static_cast<size_t>(index) * 3];
+    pixel[0] = red;
+    pixel[1] = green;
+    pixel[2] = blue;
+}
+
+void OffscreenCanvas::Blit(const uint8_t *rgb, int stride, int x0, int y0, int x1, int y1, bool lit_only) {
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, map.width());
+    y1 = std::min(y1, map.height());
+
+    for (int y = y0; y < y1; ++y) {
+        const uint32_t *targets = map.row(y);
+        const uint8_t *pixel = rgb + (static_cast<size_t>(y) * stride + x0) * 3;
+        for (int x = x0; x < x1; ++x, pixel += 3) {
+            uint32_t index = targets[x];
+            if (index == PixelMap::UNMAPPED || (lit_only && !(pixel[0] | pixel[1] | pixel[2]))) {
+                continue;
+            }
+            uint8_t *out = &framebuffer[static_cast<size_t>(index) * 3];
+            out[0] = pixel[0];
+            out[1] = pixel[1];
+            out[2] = pixel[2];
+        }
+    }
+}
+
+void OffscreenCanvas::Clear() {
+    std::fill(framebuffer.begin(), framebuffer.end(), 0);
+}
+
+void OffscreenCanvas::Fill(uint8_t red, uint8_t green, uint8_t blue) {
+    for (size_t i = 0; i < framebuffer.size(); i += 3) {
+        framebuffer[i] = red;
+        framebuffer[i + 1] = green;
+        framebuffer[i + 2] = blue;
+    }
+}
+
+void OffscreenCanvas::SetBrightness(uint8_t value) {
+    brightness_value = value;
+}
+
+uint8_t OffscreenCanvas::brightness() const {
+    return brightness_value;
+}
+
+int OffscreenCanvas::physicalWidth() const {
+    return map.physicalWidth();
+}
+
+int OffscreenCanvas::physicalHeight() const {
+    return map.physicalHeight();
+}
+
+const std::vector<uint8_t> &OffscreenCanvas::pixels() const {
+    return framebuffer;
+}
+
+bool OffscreenCanvas::WritePPM(const std::string &path) const {
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f) {
+        fprintf(stderr, "Couldn't open %s for writing\n", path.c_str());
+        return false;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", map.physicalWidth(), map.physicalHeight());
+    bool ok = fwrite(framebuffer.data(), 1, framebuffer.size(), f) == framebuffer.size();
+    fclose(f);
+    return ok;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "canvas.h"
+#include "pixel-mapper.h"
+#include "pixel_map.h"
+
+/**
+ * In-memory RGB framebuffer implementing the rgb_matrix::Canvas interface.
+ *
+ * The buffer is laid out like the physical panel chain (cols * chain by
+ * rows * parallel). Pixel mappers applied with ApplyPixelMapper() change the
+ * visible geometry exactly like RGBMatrix::ApplyPixelMapper() does, so code
+ * drawing into this canvas sees the same width/height and lands on the same
+ * physical pixels as it would on the real sign. The mapper chain is
+ * flattened into a PixelMap, so each pixel costs one table lookup.
+ */
+struct OffscreenCanvas : public rgb_matrix::Canvas {
+public:
+    /**
+     * Create a blank canvas with the given physical dimensions.
+     * @param physical_width Width of the panel chain in pixels
+     * @param physical_height Height of the panel chain in pixels
+     */
+    OffscreenCanvas(int physical_width, int physical_height);
+
+    /**
+     * Apply a pixel mapper on top of the current geometry.
+     * @param mapper Mapper from rgb_matrix::FindPixelMapper (not owned)
+     * @return true if the mapper accepted the current geometry
+     */
+    bool ApplyPixelMapper(const rgb_matrix::PixelMapper *mapper);
+
+    // rgb_matrix::Canvas interface (visible coordinates)
+    int width() const override;
+    int height() const override;
+    void SetPixel(int x, int y, uint8_t red, uint8_t green, uint8_t blue) override;
+    void Clear() override;
+    void Fill(uint8_t red, uint8_t green, uint8_t blue) override;
+
+    void SetBrightness(uint8_t value);
+    uint8_t brightness() const;
+
+    int physicalWidth() const;
+    int physicalHeight() const;
+
+    /**
+     * Copy a rectangle of a row-major RGB image in visible coordinates, one
+     * linear pass per row through the pixel map.
+     * @param rgb Source image, 3 bytes per pixel, same visible geometry as this canvas
+     * @param stride Source row length in pixels
+     * @param x0 Left edge (inclusive)
+     * @param y0 Top edge (inclusive)
+     * @param x1 Right edge (exclusive)
+     * @param y1 Bottom edge (exclusive)
+     * @param lit_only Skip black source pixels, leaving the destination as is
+     */
+    void Blit(const uint8_t *rgb, int stride, int x0, int y0, int x1, int y1, bool lit_only);
+
+    /**
+     * Raw physical framebuffer, 3 bytes (r,g,b) per pixel, row-major.
+     */
+    const std::vector<uint8_t> &pixels() const;
+
+    /**
+     * Write the physical framebuffer as a binary PPM image.
+     * @param path Output file path
+     * @return true on success
+     */
+    bool WritePPM(const std::string &path) const;
+
+private:
+    PixelMap map;
+    uint8_t brightness_value = 100;
+
+    std::vector<uint8_t> framebuffer;
+};
@@ -1,95 +1,178 @@
 #include "parsecommand.h"
+#include "frame_ring.h"
 #include "sign.h"
-#include <cctype>
-#include <sstream>
+#include <charconv>
+#include <cmath>
+
+Rect Renderable::Bounds(const Sign &sign) const {
+    return Rect{0, 0, static_cast<int>(sign.width), static_cast<int>(sign.height)};
+}
 
 TextObject::TextObject(const std::string &t, size_t xpos, size_t ypos, const rgb_matrix::Color &c, const std::string &font)
     : text(t), x(xpos), y(ypos), color(c), font_name(font) {
     type = RenderableType::STATIC;
 }
 
-void TextObject::Render(Sign &sign) {
+void TextObject::Prepare(Sign &sign) {
+    if (atlas) {
+        return;
+    }
     // Get the font for this text object from the sign's font cache
-    const rgb_matrix::Font* font = sign.getFont(font_name);
-    if (!font) {
-        font = &sign.current_font; // Fallback to current font
+    atlas = sign.getAtlas(font_name);
+    font_resolved = atlas != nullptr;
+    if (!atlas) {
+        atlas = sign.currentFont(); // Fallback to current font
     }
-    sign.drawText(text, x, y, color, *font);
 }
 
-TextScrollingObject::TextScrollingObject(const std::string &t, size_t ypos, size_t spd, const rgb_matrix::Color &c, const std::string &font)
-    : text(t), y(ypos), speed(spd), color(c), font_name(font) {
+void TextObject::Render(Sign &sign) {
+    sign.drawText(text, x, y, color, *atlas);
+}
+
+void TextObject::Patch(Sign &, const ItemPatch &patch) {
+    if (patch.text) {
+        text = *patch.text;
+    }
+    if (patch.color) {
+        color = *patch.color;
+    }
+    if (patch.x) {
+        x = *patch.x;
+    }
+    if (patch.y) {
+        y = *patch.y;
+    }
+}
+
+TextScrollingObject::TextScrollingObject(const std::string &t, size_t ypos, size_t spd, const rgb_matrix::Color &c, const std::string &font, bool dither)
+    : text(t), y(ypos), speed(spd), color(c), font_name(font), temporal_dither(dither) {
     type = RenderableType::SCROLLING;
-    current_x_offset = LedSignConstants::DEFAULT_DISPLAY_WIDTH; // Start from right edge
+    scroll_position = LedSignConstants::DEFAULT_DISPLAY_WIDTH; // Start from right edge
+    current_x_offset = static_cast<int>(scroll_position);
     last_update = std::chrono::steady_clock::now();
 }
 
-void TextScrollingObject::Render(Sign &sign) {
+void TextScrollingObject::Prepare(Sign &sign) {
+    if (atlas) {
+        return;
+    }
     // Get the font for this text object from the sign's font cache
-    const rgb_matrix::Font* font = sign.getFont(font_name);
-    if (!font) {
-        font = &sign.current_font; // Fallback to current font
+    atlas = sign.getAtlas(font_name);
+    font_resolved = atlas != nullptr;
+    if (!atlas) {
+        atlas = sign.currentFont(); // Fallback to current font
     }
-    
+
+    // Rasterize the text once; every frame after that is a window blit
+    strip = TextStrip::Rasterize(text, *atlas);
+}
+
+void TextScrollingObject::Render(Sign &sign) {
     // Calculate time delta for smooth animation
     auto now = std::chrono::steady_clock::now();
-    auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_update);
+    if (!started) {
+        last_update = now; // Scheduled scenes are built long before they show
+        started = true;
+    }
+    std::chrono::duration<double> delta = now - last_update;
     last_update = now;
     
-    // Update scroll position based on speed (pixels per second)
-    float pixels_per_ms = static_cast<float>(speed) / 1000.0f;
-    current_x_offset -= static_cast<int>(delta.count() * pixels_per_ms);
-    
-    // Calculate text width to know when to reset
-    int text_width = 0;
-    for (char c : text) {
-        text_width += font->CharacterWidth(c);
-    }
+    // Accumulate the exact position so slow speeds still move between frames
+    scroll_position -= delta.count() * static_cast<double>(speed);
     
     // Reset to right side when text has completely scrolled off left
-    if (current_x_offset < -text_width) {
-        current_x_offset = static_cast<int>(sign.width);
+    if (scroll_position < -strip.width) {
+        scroll_position = static_cast<double>(sign.width);
     }
+
+    // Quantize to a pixel column. With dithering, a rotating threshold makes
+    // the drawn column average out to the exact position over 4 frames.
+    static constexpr double DITHER_THRESHOLDS[4] = {0.125, 0.625, 0.375, 0.875};
+    double threshold = temporal_dither ? DITHER_THRESHOLDS[frame_counter++ & 3] : 0.0;
+    current_x_offset = static_cast<int>(std::floor(scroll_position + threshold));
     
-    // Render the text at current position
-    sign.drawText(text, current_x_offset, y, color, *font);
+    // Render the visible part of the text at current position
+    sign.drawStrip(strip, current_x_offset, y, color);
 }
 
-// Helper function to safely parse an unsigned integer without exceptions
-bool safeParseUInt(const std::string& str, size_t& result) {
-    if (str.empty()) {
-        return false;
-    }
-    
-    // Check if all characters are digits
-    for (char c : str) {
-        if (!std::isdigit(c)) {
-            return false;
+void TextScrollingObject::Patch(Sign &sign, const ItemPatch &patch) {
+    // Only the new text is rasterized; the scroll position carries on
+    if (patch.text) {
+        text = *patch.text;
+        if (atlas) {
+            strip = TextStrip::Rasterize(text, *atlas);
+        } else {
+            Prepare(sign);
         }
     }
-    
-    // Simple manual parsing to avoid std::stoul exceptions
-    result = 0;
-    for (char c : str) {
-        size_t digit = c - '0';
-        // Check for overflow before multiplying
-        if (result > (SIZE_MAX - digit) / 10) {
-            return false; // Would overflow
+    if (patch.color) {
+        color = *patch.color;
+    }
+    if (patch.y) {
+        y = *patch.y;
+    }
+}
+
+Rect TextScrollingObject::Bounds(const Sign &sign) const {
+    const int top = static_cast<int>(y) - strip.baseline;
+    return Rect{current_x_offset, top, current_x_offset + strip.width, top + strip.height}
+        .clipped(static_cast<int>(sign.width), static_cast<int>(sign.height));
+}
+
+ImageObject::ImageObject(size_t w, size_t h, std::vector<uint8_t> rgb)
+    : width(w), height(h), pixels(std::move(rgb)) {
+    type = RenderableType::STATIC;
+}
+
+void ImageObject::Render(Sign &sign) {
+    sign.drawImage(pixels.data(), static_cast<int>(width), static_cast<int>(height));
+}
+
+SharedFrameObject::SharedFrameObject(std::shared_ptr<const FrameRing> r) : ring(std::move(r)) {
+    type = RenderableType::EXTERNAL;
+}
+
+void SharedFrameObject::Render(Sign &sign) {
+    // Copy the slot out and only keep the copy if the producer didn't lap us
+    // mid-copy; if every attempt tears, the last good frame is drawn again
+    const size_t frame_bytes = static_cast<size_t>(ring->width()) * ring->height() * 3;
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        uint32_t slot, sequence;
+        const uint8_t *pixels = ring->acquireLatest(slot, sequence);
+        if (!pixels) {
+            break;
+        }
+        copy.assign(pixels, pixels + frame_bytes);
+        if (ring->validate(slot, sequence)) {
+            last_frame.swap(copy);
+            break;
         }
-        result = result * 10 + digit;
     }
-    
-    return true;
+    if (last_frame.size() == frame_bytes) {
+        sign.drawImage(last_frame.data(), static_cast<int>(ring->width()), static_cast<int>(ring->height()));
+    }
+}
+
+// Helper function to safely parse an unsigned integer without exceptions
+bool safeParseUInt(std::string_view str, size_t& result) {
+    if (str.empty()) {
+        return false;
+    }
+
+    // from_chars rejects signs and whitespace, reports overflow, and never allocates
+    const char* end = str.data() + str.size();
+    auto [ptr, ec] = std::from_chars(str.data(), end, result);
+    return ec == std::errc() && ptr == end;
 }
 
 // Helper function to safely extract field between semicolons
-bool extractField(const std::string& config, size_t& pos, std::string& result) {
+bool extractField(std::string_view config, size_t& pos, std::string_view& result) {
     if (pos >= config.length()) {
         return false;
     }
     
     size_t semicolon_pos = config.find(';', pos);
-    if (semicolon_pos == std::string::npos) {
+    if (semicolon_pos == std::string_view::npos) {
         return false;
     }
     
@@ -104,12 +187,8 @@ bool extractField(const std::string& config, size_t& pos, std::string& result) {
 }
 
 // Helper function to validate END token
-bool validateEndToken(const std::string& config, size_t& pos) {
-    if (pos + 3 > config.length()) {
-        return false;
-    }
-    
-    if (config.substr(pos, 3) != "END") {
+bool validateEndToken(std::string_view config, size_t& pos) {
+    if (config.compare(pos, 3, "END") != 0 || pos + 3 > config.length()) {
         return false;
     }
     
@@ -123,92 +202,224 @@ bool validateEndToken(const std::string& config, size_t& pos) {
     return true;
 }
 
-std::vector<std::shared_ptr<Renderable>> parseSignConfig(const std::string &config) {
+// Helper function to parse a color component list "(r,g,b)"; the parentheses
+// and spaces around the numbers are optional
+bool parseColor(std::string_view str, rgb_matrix::Color& color) {
+    const char* it = str.data();
+    const char* end = it + str.size();
+    auto skipSpaces = [&]() {
+        while (it < end && *it == ' ') {
+            ++it;
+        }
+    };
+
+    skipSpaces();
+    bool parenthesized = it < end && *it == '(';
+    if (parenthesized) {
+        ++it;
+    }
+
+    uint8_t* components[3] = {&color.r, &color.g, &color.b};
+    for (int i = 0; i < 3; ++i) {
+        if (i > 0) {
+            skipSpaces();
+            if (it == end || *it != ',') {
+                return false;
+            }
+            ++it;
+        }
+        skipSpaces();
+        unsigned value;
+        auto [ptr, ec] = std::from_chars(it, end, value);
+        if (ec != std::errc() || value > 255) {
+            return false;
+        }
+        *components[i] = static_cast<uint8_t>(value);
+        it = ptr;
+    }
+
+    skipSpaces();
+    if (parenthesized) {
+        if (it == end || *it != ')') {
+            return false;
+        }
+        ++it;
+        skipSpaces();
+    }
+    return it == end;
+}
+
+// Helper function to read the optional font field that precedes END
+bool extractFontField(std::string_view config, size_t& pos, std::string_view& font_name) {
+    std::string_view font_str;
+    size_t field_pos = pos;
+    if (extractField(config, field_pos, font_str)) {
+        pos = field_pos;
+        if (!font_str.empty()) {
+            font_name = font_str;
+        }
+        return true;
+    }
+    // No further field: font is optional as long as END follows
+    return config.compare(pos, 3, "END") == 0;
+}
+
+bool parseItemPatch(std::string_view spec, ItemPatch &patch) {
+    size_t pos = spec.find(';');
+    if (pos == std::string_view::npos || pos == 0) {
+        return false;
+    }
+    patch.key = std::string(spec.substr(0, pos));
+    ++pos;
+
+    bool changed = false;
+    while (pos < spec.length()) {
+        size_t end = spec.find(';', pos);
+        if (end == std::string_view::npos) {
+            end = spec.length();
+        }
+        std::string_view field = spec.substr(pos, end - pos);
+        pos = end + 1;
+        if (field.empty()) {
+            continue; // Trailing or doubled semicolon
+        }
+
+        size_t equals = field.find('=');
+        if (equals == std::string_view::npos) {
+            return false;
+        }
+        std::string_view name = field.substr(0, equals);
+        std::string_view value = field.substr(equals + 1);
+        size_t number;
+        if (name == "text") {
+            patch.text = std::string(value);
+        } else if (name == "color") {
+            rgb_matrix::Color color;
+            if (!parseColor(value, color)) {
+                return false;
+            }
+            patch.color = color;
+        } else if (name == "x" && safeParseUInt(value, number)) {
+            patch.x = number;
+        } else if (name == "y" && safeParseUInt(value, number)) {
+            patch.y = number;
+        } else {
+            return false;
+        }
+        changed = true;
+    }
+    return changed;
+}
+
+Scene parseSignConfig(std::string_view config) {
     // Parse configuration for mixed static and scrolling objects
     // Format: "TYPE;text;x;y;(r,g,b);[font];[speed];END" where TYPE is STATIC or SCROLL
+    // or "FPS;n;END" for the scene frame rate
     // Examples:
     // "STATIC;Hello World;10;20;(255,0,0);7x13;END;SCROLL;Breaking News;15;(0,255,0);50;6x10;END"
+    //
+    // Fields are views into config; only the strings kept by renderables are copied.
+
+    Scene scene;
+    auto &renderables = scene.renderables;
 
-    std::vector<std::shared_ptr<Renderable>> renderables;
+    // Every object ends with an END field, so counting them bounds the item
+    // count and the item array is allocated once
+    size_t item_count = 0;
+    for (size_t end = config.find("END"); end != std::string_view::npos; end = config.find("END", end + 3)) {
+        ++item_count;
+    }
+    renderables.reserve(item_count);
     size_t pos = 0;
 
     while (pos < config.length()) {
         size_t start_pos = pos; // Safety check for infinite loops
         
-        // Get object type
-        std::string type;
+        // Get object type, optionally followed by #key
+        std::string_view type;
         if (!extractField(config, pos, type)) {
             break; // End of config or malformed
         }
+        std::string_view key;
+        size_t hash = type.find('#');
+        if (hash != std::string_view::npos) {
+            key = type.substr(hash + 1);
+            type = type.substr(0, hash);
+            if (key.empty() || type == "FPS") {
+                fprintf(stderr, "Invalid key on object type '%.*s'\n", (int)type.size(), type.data());
+                return {};
+            }
+        }
 
         // Get text
-        std::string text;
+        std::string_view text;
         if (!extractField(config, pos, text)) {
-            fprintf(stderr, "Invalid config format: missing text after type '%s'\n", type.c_str());
+            fprintf(stderr, "Invalid config format: missing text after type '%.*s'\n", (int)type.size(), type.data());
             return {};
         }
 
-        if (type == "STATIC") {
+        if (type == "FPS") {
+            // Scene frame rate: the text field holds the value
+            size_t fps;
+            if (!safeParseUInt(text, fps) ||
+                fps < static_cast<size_t>(LedSignConstants::MIN_TARGET_FPS) ||
+                fps > static_cast<size_t>(LedSignConstants::MAX_TARGET_FPS)) {
+                fprintf(stderr, "Invalid frame rate: '%.*s' (expected %d-%d)\n", (int)text.size(), text.data(),
+                        LedSignConstants::MIN_TARGET_FPS, LedSignConstants::MAX_TARGET_FPS);
+                return {};
+            }
+
+            if (!validateEndToken(config, pos)) {
+                fprintf(stderr, "Invalid FPS config: missing or malformed END token\n");
+                return {};
+            }
+
+            scene.target_fps = static_cast<int>(fps);
+
+        } else if (type == "STATIC") {
             // Static text: x;y;(r,g,b);font;END
             
             // Get x position
-            std::string x_str;
+            std::string_view x_str;
             if (!extractField(config, pos, x_str)) {
                 fprintf(stderr, "Invalid static config: missing x position\n");
                 return {};
             }
             size_t x;
             if (!safeParseUInt(x_str, x)) {
-                fprintf(stderr, "Invalid x position: '%s' (must be a positive integer)\n", x_str.c_str());
+                fprintf(stderr, "Invalid x position: '%.*s' (must be a positive integer)\n", (int)x_str.size(), x_str.data());
                 return {};
             }
 
             // Get y position
-            std::string y_str;
+            std::string_view y_str;
             if (!extractField(config, pos, y_str)) {
                 fprintf(stderr, "Invalid static config: missing y position\n");
                 return {};
             }
             size_t y;
             if (!safeParseUInt(y_str, y)) {
-                fprintf(stderr, "Invalid y position: '%s' (must be a positive integer)\n", y_str.c_str());
+                fprintf(stderr, "Invalid y position: '%.*s' (must be a positive integer)\n", (int)y_str.size(), y_str.data());
                 return {};
             }
 
             // Get color
-            std::string color_str;
+            std::string_view color_str;
             if (!extractField(config, pos, color_str)) {
                 fprintf(stderr, "Invalid static config: missing color\n");
                 return {};
             }
-
-            // Parse color (r,g,b)
-            int r, g, b;
-            std::stringstream ss(color_str);
-            char ignore;
-            ss >> ignore >> r >> ignore >> g >> ignore >> b >> ignore;
-            
-            if (ss.fail() || r < 0 || r > 255 || g < 0 || g > 255 || b < 0 || b > 255) {
-                fprintf(stderr, "Invalid color format: '%s' (expected format: (r,g,b) with values 0-255)\n", color_str.c_str());
+            rgb_matrix::Color color;
+            if (!parseColor(color_str, color)) {
+                fprintf(stderr, "Invalid color format: '%.*s' (expected format: (r,g,b) with values 0-255)\n", (int)color_str.size(), color_str.data());
                 return {};
             }
 
             // Get font (optional, defaults to 6x10)
-            std::string font_name = "6x10"; // Default font
-            std::string font_str;
-            if (extractField(config, pos, font_str)) {
-                if (!font_str.empty()) {
-                    font_name = font_str;
-                }
-            } else {
-                // If extractField failed, we might be at END token, rewind pos
-                // Try to validate END token directly
-                if (pos < config.length() && config.substr(pos, 3) == "END") {
-                    // We're at END, font is optional so use default
-                } else {
-                    fprintf(stderr, "Invalid static config: missing or malformed font/END token\n");
-                    return {};
-                }
+            std::string_view font_name = "6x10"; // Default font
+            if (!extractFontField(config, pos, font_name)) {
+                fprintf(stderr, "Invalid static config: missing or malformed font/END token\n");
+                return {};
             }
 
             // Validate END token
@@ -217,69 +428,59 @@ std::vector<std::shared_ptr<Renderable>> parseSignConfig(const std::string &conf
                 return {};
             }
 
-            renderables.push_back(std::make_shared<TextObject>(text, x, y, rgb_matrix::Color(r, g, b), font_name));
+            renderables.emplace_back(std::in_place_type<TextObject>, std::string(text), x, y, color, std::string(font_name));
 
         } else if (type == "SCROLL") {
-            // Scrolling text: y;(r,g,b);speed;font;END
+            // Scrolling text: y;(r,g,b);speed;font;[DITHER;]END
             
             // Get y position
-            std::string y_str;
+            std::string_view y_str;
             if (!extractField(config, pos, y_str)) {
                 fprintf(stderr, "Invalid scroll config: missing y position\n");
                 return {};
             }
             size_t y;
             if (!safeParseUInt(y_str, y)) {
-                fprintf(stderr, "Invalid y position: '%s' (must be a positive integer)\n", y_str.c_str());
+                fprintf(stderr, "Invalid y position: '%.*s' (must be a positive integer)\n", (int)y_str.size(), y_str.data());
                 return {};
             }
 
             // Get color
-            std::string color_str;
+            std::string_view color_str;
             if (!extractField(config, pos, color_str)) {
                 fprintf(stderr, "Invalid scroll config: missing color\n");
                 return {};
             }
-
-            // Parse color (r,g,b)
-            int r, g, b;
-            std::stringstream ss(color_str);
-            char ignore;
-            ss >> ignore >> r >> ignore >> g >> ignore >> b >> ignore;
-            
-            if (ss.fail() || r < 0 || r > 255 || g < 0 || g > 255 || b < 0 || b > 255) {
-                fprintf(stderr, "Invalid color format: '%s' (expected format: (r,g,b) with values 0-255)\n", color_str.c_str());
+            rgb_matrix::Color color;
+            if (!parseColor(color_str, color)) {
+                fprintf(stderr, "Invalid color format: '%.*s' (expected format: (r,g,b) with values 0-255)\n", (int)color_str.size(), color_str.data());
                 return {};
             }
 
             // Get speed
-            std::string speed_str;
+            std::string_view speed_str;
             if (!extractField(config, pos, speed_str)) {
                 fprintf(stderr, "Invalid scroll config: missing speed\n");
                 return {};
             }
             size_t speed;
             if (!safeParseUInt(speed_str, speed)) {
-                fprintf(stderr, "Invalid speed: '%s' (must be a positive integer)\n", speed_str.c_str());
+                fprintf(stderr, "Invalid speed: '%.*s' (must be a positive integer)\n", (int)speed_str.size(), speed_str.data());
                 return {};
             }
 
             // Get font (optional, defaults to 6x10)
-            std::string font_name = "6x10"; // Default font
-            std::string font_str;
-            if (extractField(config, pos, font_str)) {
-                if (!font_str.empty()) {
-                    font_name = font_str;
-                }
-            } else {
-                // If extractField failed, we might be at END token, rewind pos
-                // Try to validate END token directly
-                if (pos < config.length() && config.substr(pos, 3) == "END") {
-                    // We're at END, font is optional so use default
-                } else {
-                    fprintf(stderr, "Invalid scroll config: missing or malformed font/END token\n");
-                    return {};
-                }
+            std::string_view font_name = "6x10"; // Default font
+            if (!extractFontField(config, pos, font_name)) {
+                fprintf(stderr, "Invalid scroll config: missing or malformed font/END token\n");
+                return {};
+            }
+
+            // Optional temporal dithering flag
+            bool dither = false;
+            if (config.compare(pos, 7, "DITHER;") == 0) {
+                dither = true;
+                pos += 7;
             }
 
             // Validate END token
@@ -288,13 +489,17 @@ std::vector<std::shared_ptr<Renderable>> parseSignConfig(const std::string &conf
                 return {};
             }
 
-            renderables.push_back(std::make_shared<TextScrollingObject>(text, y, speed, rgb_matrix::Color(r, g, b), font_name));
+            renderables.emplace_back(std::in_place_type<TextScrollingObject>, std::string(text), y, speed, color, std::string(font_name), dither);
 
         } else {
-            fprintf(stderr, "Unknown object type: '%s' (expected STATIC or SCROLL)\n", type.c_str());
+            fprintf(stderr, "Unknown object type: '%.*s' (expected STATIC, SCROLL or FPS)\n", (int)type.size(), type.data());
             return {};
         }
 
+        if (!key.empty()) {
+            std::visit([key](Renderable &object) { object.key = std::string(key); }, renderables.back());
+        }
+
         // Safety check: ensure position has advanced to prevent infinite loops
         if (pos <= start_pos) {
             fprintf(stderr, "Parser error: position did not advance (infinite loop detected)\n");
@@ -302,5 +507,5 @@ std::vector<std::shared_ptr<Renderable>> parseSignConfig(const std::string &conf
         }
     }
     
-    return renderables;
-}
\ No newline at end of file
+    return scene;
+}
@@ -1,29 +1,94 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <variant>
 #include <vector>
+#include "constants.h"
 #include "led-matrix.h"
+#include "text_strip.h"
 
-// Forward declaration
+// Forward declarations
 struct Sign;
+struct FrameRing;
 
 enum class RenderableType {
     STATIC,
     SCROLLING,
     ANIMATED,
+    EXTERNAL, // Redrawn when its source signals new content, not every frame
 };
 
 /**
- * Abstract base class for renderable objects on the sign.
+ * Pixel rectangle in display coordinates, half-open: [x0, x1) x [y0, y1).
+ */
+struct Rect {
+    int x0 = 0;
+    int y0 = 0;
+    int x1 = 0;
+    int y1 = 0;
+
+    bool empty() const { return x0 >= x1 || y0 >= y1; }
+
+    Rect clipped(int width, int height) const {
+        Rect r{x0 < 0 ? 0 : x0, y0 < 0 ? 0 : y0, x1 > width ? width : x1, y1 > height ? height : y1};
+        return r.empty() ? Rect{} : r;
+    }
+};
+
+/**
+ * Changes to one keyed scene object, as sent with PATCH. Fields left empty
+ * are kept.
+ */
+struct ItemPatch {
+    std::string key;
+    std::optional<std::string> text;
+    std::optional<rgb_matrix::Color> color;
+    std::optional<size_t> x; // Ignored by scrolling text, which keeps its position
+    std::optional<size_t> y;
+};
+
+/**
+ * Base class for renderable objects on the sign.
+ *
+ * Scenes hold objects by value in a SceneItem and call them through
+ * std::visit, so there are no virtual functions: each object type defines
+ * Render() and hides the defaults below where it needs to.
  */
 struct Renderable {
-    RenderableType type;
+    RenderableType type = RenderableType::STATIC;
+    std::string key; // Optional, from TYPE#key in the SET format; PATCH finds the object by it
 public:
-    Renderable() = default;
-    virtual ~Renderable() = default;
-    virtual void Render(Sign &sign) = 0;
+    /**
+     * Resolve what the object needs from the sign (fonts, rasterized text)
+     * so Render() does no lookups. Called when the scene is published, off
+     * the render thread; calling it again does nothing.
+     */
+    void Prepare(Sign &) {}
+
+    /**
+     * Area touched by the most recent Render() call. Used to repaint only
+     * what animated objects dirtied; defaults to the whole display.
+     */
+    Rect Bounds(const Sign &sign) const;
+
+    /**
+     * Apply a PATCH on the render thread, between frames. Objects with
+     * nothing to patch ignore it.
+     */
+    void Patch(Sign &, const ItemPatch &) {}
+
+    bool animated() const { return type == RenderableType::SCROLLING || type == RenderableType::ANIMATED; }
+
+    /**
+     * Name of the font the object draws with, empty if it draws no text or
+     * Prepare() fell back to the current font.
+     */
+    std::string fontName() const { return {}; }
 };
 
 /**
@@ -37,6 +102,10 @@ public:
     rgb_matrix::Color color = rgb_matrix::Color(255, 255, 255); // Default white color
     std::string font_name = "6x10"; // Default font size
 
+    // Resolved by Prepare(): font_name's atlas, or the current font if it can't be loaded
+    std::shared_ptr<const GlyphAtlas> atlas;
+    bool font_resolved = false; // atlas is font_name's, not the fallback
+
     TextObject(
         const std::string &t,
         size_t xpos,
@@ -45,7 +114,10 @@ public:
         const std::string &font = "6x10"
     );
 
-    void Render(Sign &sign) override;
+    void Prepare(Sign &sign);
+    void Render(Sign &sign);
+    void Patch(Sign &sign, const ItemPatch &patch);
+    std::string fontName() const { return font_resolved ? font_name : std::string(); }
 };
 
 /**
@@ -59,30 +131,112 @@ public:
     rgb_matrix::Color color = rgb_matrix::Color(255, 255, 255); // Default white color
     std::string font_name = "6x10"; // Default font size
     
+    bool temporal_dither = false; // Alternate between neighbouring pixels for sub-pixel positions
+
     // Animation state - not mutable anymore, will be handled properly
-    int current_x_offset = 0;
+    double scroll_position = 0.0; // Exact left edge in pixels, never truncated
+    int current_x_offset = 0;     // Pixel column drawn this frame
+    uint32_t frame_counter = 0;
+    bool started = false; // Timing starts with the first frame, not when the scene was built
     std::chrono::steady_clock::time_point last_update = std::chrono::steady_clock::now();
+
+    // Resolved by Prepare(): the font's atlas and the text rasterized with it,
+    // so every frame is a window blit
+    std::shared_ptr<const GlyphAtlas> atlas;
+    bool font_resolved = false; // atlas is font_name's, not the fallback
+    TextStrip strip;
     
     TextScrollingObject(
         const std::string &t,
         size_t ypos,
         size_t spd,
         const rgb_matrix::Color &c = rgb_matrix::Color(255, 255, 255),
-        const std::string &font = "6x10"
+        const std::string &font = "6x10",
+        bool dither = false
     );
     
-    void Render(Sign &sign) override;
+    void Prepare(Sign &sign);
+    void Render(Sign &sign);
+    void Patch(Sign &sign, const ItemPatch &patch);
+    Rect Bounds(const Sign &sign) const;
+    std::string fontName() const { return font_resolved ? font_name : std::string(); }
 };
 
+/**
+ * Externally rendered RGB frame drawn from the top-left corner of the display.
+ */
+struct ImageObject : public Renderable {
+public:
+    size_t width;
+    size_t height;
+    std::vector<uint8_t> pixels; // Row-major RGB, 3 bytes per pixel
+
+    ImageObject(size_t w, size_t h, std::vector<uint8_t> rgb);
+
+    void Render(Sign &sign);
+};
+
+/**
+ * Newest complete frame of the shared-memory frame ring, read in place.
+ * The sign redraws it whenever the producer rings the doorbell.
+ */
+struct SharedFrameObject : public Renderable {
+public:
+    std::shared_ptr<const FrameRing> ring;
+    std::vector<uint8_t> last_frame; // Last frame that was copied without tearing
+    std::vector<uint8_t> copy;       // Copy in progress, kept to reuse its allocation
+
+    explicit SharedFrameObject(std::shared_ptr<const FrameRing> r);
+
+    void Render(Sign &sign);
+};
+
+/**
+ * One object of a scene, stored inline so a scene's objects sit in a single
+ * contiguous array.
+ */
+using SceneItem = std::variant<TextObject, TextScrollingObject, ImageObject, SharedFrameObject>;
+
+/**
+ * Common part of a scene item.
+ */
+inline const Renderable &itemBase(const SceneItem &item) {
+    return std::visit([](const Renderable &object) -> const Renderable & { return object; }, item);
+}
+
 // Helper functions for parsing
-bool safeParseUInt(const std::string& str, size_t& result);
-bool extractField(const std::string& config, size_t& pos, std::string& result);
-bool validateEndToken(const std::string& config, size_t& pos);
+bool safeParseUInt(std::string_view str, size_t& result);
+bool extractField(std::string_view config, size_t& pos, std::string_view& result);
+bool validateEndToken(std::string_view config, size_t& pos);
+bool parseColor(std::string_view str, rgb_matrix::Color& color);
+bool extractFontField(std::string_view config, size_t& pos, std::string_view& font_name);
+
+/**
+ * Parse a PATCH argument: "key;field=value;..." where field is text, color,
+ * x or y, e.g. "queue;text=42;color=(255,0,0)".
+ * @return true if the key and at least one valid field were given
+ */
+bool parseItemPatch(std::string_view spec, ItemPatch &patch);
+
+/**
+ * A parsed scene: the objects to render plus scene-wide settings.
+ */
+struct Scene {
+    std::vector<SceneItem> renderables;
+    int target_fps = LedSignConstants::TARGET_FPS; // Frame rate while animating
+    int fade_ms = 0; // Cross-fade from the picture on display over this long, 0 to cut
+    uint64_t generation = 0; // Stamped when published; PATCH waits for it to be live
+};
 
 /**
- * Parse sign configuration string into renderable objects.
- * Format: "TYPE;text;x;y;(r,g,b);[font];[speed];END" where TYPE is STATIC or SCROLL
+ * Parse sign configuration string into a scene.
+ * Format: "TYPE;text;x;y;(r,g,b);[font];[speed];END" where TYPE is STATIC or SCROLL,
+ * or "FPS;n;END" to set the scene frame rate. SCROLL items accept an optional
+ * "DITHER" field after the font to enable temporal dithering. STATIC and SCROLL
+ * may be written TYPE#key to give the object a key for PATCH.
  * Examples:
  * "STATIC;Hello World;10;20;(255,0,0);7x13;END;SCROLL;Breaking News;15;(0,255,0);50;6x10;END"
+ * "FPS;30;END;SCROLL;Breaking News;15;(0,255,0);50;6x10;END"
+ * "STATIC#queue;17;0;10;(255,255,0);6x10;END"
  */
-std::vector<std::shared_ptr<Renderable>> parseSignConfig(const std::string &config);
+Scene parseSignConfig(std::string_view config);
@@ -0,0 +1,193 @@
+#include "pixel_kernels.h"
+
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PIXEL_KERNELS_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PIXEL_KERNELS_SSE2 1
+#endif
+
+namespace {
+
+// Eight bits starting at an arbitrary bit index; all eight must lie in the row
+inline uint8_t bitsAt(const uint8_t *bits, size_t bit) {
+    const size_t byte = bit >> 3;
+    const unsigned shift = bit & 7;
+    if (shift == 0) {
+        return bits[byte];
+    }
+    return static_cast<uint8_t>((bits[byte] << shift) | (bits[byte + 1] >> (8 - shift)));
+}
+
+// Rounded x / 255 for x <= 255 * 255, without a division
+inline uint8_t div255(unsigned x) {
+    x += 128;
+    return static_cast<uint8_t>((x + (x >> 8)) >> 8);
+}
+
+#if PIXEL_KERNELS_SSE2
+// The color repeated over 16 pixels, so any 16 byte window starts on a channel boundary
+struct ColorPattern {
+    alignas(16) uint8_t bytes[48];
+
+    ColorPattern(uint8_t red, uint8_t green, uint8_t blue) {
+        for (int i = 0; i < 48; i += 3) {
+            bytes[i] = red;
+            bytes[i + 1] = green;
+            bytes[i + 2] = blue;
+        }
+    }
+};
+
+// For each bitmap byte, a 24 byte mask covering its eight pixels
+struct ExpandMasks {
+    uint8_t masks[256][24];
+
+    ExpandMasks() {
+        for (int b = 0; b < 256; ++b) {
+            for (int bit = 0; bit < 8; ++bit) {
+                uint8_t m = (b & (0x80 >> bit)) ? 0xFF : 0x00;
+                masks[b][bit * 3] = m;
+                masks[b][bit * 3 + 1] = m;
+                masks[b][bit * 3 + 2] = m;
+            }
+        }
+    }
+};
+
+const ExpandMasks &expandMasks() {
+    static const ExpandMasks masks;
+    return masks;
+}
+#endif
+
+}
+
+void fillPixels(uint8_t *dst, size_t count, uint8_t red, uint8_t green, uint8_t blue) {
+    size_t i = 0;
+#if PIXEL_KERNELS_NEON
+    uint8x16x3_t color = {{vdupq_n_u8(red), vdupq_n_u8(green), vdupq_n_u8(blue)}};
+    for (; i + 16 <= count; i += 16) {
+        vst3q_u8(dst + i * 3, color);
+    }
+#elif PIXEL_KERNELS_SSE2
+    const ColorPattern pattern(red, green, blue);
+    const __m128i p0 = _mm_load_si128(reinterpret_cast<const __m128i *>(pattern.bytes));
+    const __m128i p1 = _mm_load_si128(reinterpret_cast<const __m128i *>(pattern.bytes + 16));
+    const __m128i p2 = _mm_load_si128(reinterpret_cast<const __m128i *>(pattern.bytes + 32));
+    for (; i + 16 <= count; i += 16) {
+        __m128i *out = reinterpret_cast<__m128i *>(dst + i * 3);
+        _mm_storeu_si128(out, p0);
+        _mm_storeu_si128(out + 1, p1);
+        _mm_storeu_si128(out + 2, p2);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i * 3] = red;
+        dst[i * 3 + 1] = green;
+        dst[i * 3 + 2] = blue;
+    }
+}
+
+void copyPixels(uint8_t *dst, const uint8_t *src, size_t count) {
+    // libc's memcpy is already vectorized for every target we build on
+    std::memcpy(dst, src, count * 3);
+}
+
+void expandBitsToPixels(uint8_t *dst, const uint8_t *bits, size_t bit_offset, size_t count,
+                        uint8_t red, uint8_t green, uint8_t blue) {
+    size_t i = 0;
+#if PIXEL_KERNELS_NEON
+    static const uint8_t bit_select[8] = {0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01};
+    const uint8x8_t select = vld1_u8(bit_select);
+    const uint8x8_t r = vdup_n_u8(red);
+    const uint8x8_t g = vdup_n_u8(green);
+    const uint8x8_t b = vdup_n_u8(blue);
+    for (; i + 8 <= count; i += 8) {
+        uint8_t byte = bitsAt(bits, bit_offset + i);
+        if (byte == 0) {
+            continue;
+        }
+        uint8_t *out = dst + i * 3;
+        uint8x8_t mask = vtst_u8(vdup_n_u8(byte), select);
+        uint8x8x3_t pixels = vld3_u8(out);
+        pixels.val[0] = vbsl_u8(mask, r, pixels.val[0]);
+        pixels.val[1] = vbsl_u8(mask, g, pixels.val[1]);
+        pixels.val[2] = vbsl_u8(mask, b, pixels.val[2]);
+        vst3_u8(out, pixels);
+    }
+#elif PIXEL_KERNELS_SSE2
+    const ExpandMasks &masks = expandMasks();
+    const ColorPattern pattern(red, green, blue);
+    const __m128i c0 = _mm_load_si128(reinterpret_cast<const __m128i *>(pattern.bytes));
+    const __m128i c1 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(pattern.bytes + 16));
+    for (; i + 8 <= count; i += 8) {
+        uint8_t byte = bitsAt(bits, bit_offset + i);
+        if (byte == 0) {
+            continue;
+        }
+        uint8_t *out = dst + i * 3;
+        const uint8_t *mask = masks.masks[byte];
+        __m128i m0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask));
+        __m128i m1 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(mask + 16));
+        __m128i d0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(out));
+        __m128i d1 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(out + 16));
+        d0 = _mm_or_si128(_mm_and_si128(m0, c0), _mm_andnot_si128(m0, d0));
+        d1 = _mm_or_si128(_mm_and_si128(m1, c1), _mm_andnot_si128(m1, d1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), d0);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + 16), d1);
+    }
+#endif
+    for (; i < count; ++i) {
+        size_t bit = bit_offset + i;
+        if (bits[bit >> 3] & (0x80 >> (bit & 7))) {
+            dst[i * 3] = red;
+            dst[i * 3 + 1] = green;
+            dst[i * 3 + 2] = blue;
+        }
+    }
+}
+
+void blendPixels(uint8_t *dst, const uint8_t *src, size_t count, uint8_t alpha) {
+    const size_t bytes = count * 3;
+    const uint8_t inverse = 255 - alpha;
+    size_t i = 0;
+#if PIXEL_KERNELS_NEON
+    const uint8x8_t a = vdup_n_u8(alpha);
+    const uint8x8_t inv = vdup_n_u8(inverse);
+    for (; i + 16 <= bytes; i += 16) {
+        uint8x16_t s = vld1q_u8(src + i);
+        uint8x16_t d = vld1q_u8(dst + i);
+        uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(s), a), vget_low_u8(d), inv);
+        uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(s), a), vget_high_u8(d), inv);
+        // (x + ((x + 128) >> 8) + 128) >> 8 is the rounded x / 255
+        uint8x8_t out_lo = vraddhn_u16(lo, vrshrq_n_u16(lo, 8));
+        uint8x8_t out_hi = vraddhn_u16(hi, vrshrq_n_u16(hi, 8));
+        vst1q_u8(dst + i, vcombine_u8(out_lo, out_hi));
+    }
+#elif PIXEL_KERNELS_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i a = _mm_set1_epi16(alpha);
+    const __m128i inv = _mm_set1_epi16(inverse);
+    const __m128i round = _mm_set1_epi16(128);
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), a),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), a),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv));
+        lo = _mm_add_epi16(lo, round);
+        hi = _mm_add_epi16(hi, round);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < bytes; ++i) {
+        dst[i] = div255(src[i] * alpha + dst[i] * inverse);
+    }
+}
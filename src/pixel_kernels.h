@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Row kernels for packed RGB888 pixels (3 bytes per pixel, r,g,b).
+ *
+ * Each kernel has a NEON path (ARMv7/ARMv8 Pis), an SSE2 path (x86 builds)
+ * and a portable fallback chosen at compile time; all paths produce
+ * identical results. The ARMv6 Pi Zero and Pi 1 have no NEON and use the
+ * fallback.
+ */
+
+/**
+ * Set count pixels to one color.
+ */
+void fillPixels(uint8_t *dst, size_t count, uint8_t red, uint8_t green, uint8_t blue);
+
+/**
+ * Copy count pixels. Source and destination must not overlap.
+ */
+void copyPixels(uint8_t *dst, const uint8_t *src, size_t count);
+
+/**
+ * Expand a run of a 1-bit MSB-first bitmap row: pixels whose bit is set
+ * become the color, the others are left untouched.
+ * @param dst First destination pixel
+ * @param bits Bitmap row
+ * @param bit_offset Index of the first bit to expand
+ * @param count Number of bits (pixels) to expand
+ */
+void expandBitsToPixels(uint8_t *dst, const uint8_t *bits, size_t bit_offset, size_t count,
+                        uint8_t red, uint8_t green, uint8_t blue);
+
+/**
+ * Blend src over dst: dst = (src * alpha + dst * (255 - alpha)) / 255, rounded.
+ */
+void blendPixels(uint8_t *dst, const uint8_t *src, size_t count, uint8_t alpha);
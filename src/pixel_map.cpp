@@ -0,0 +1,42 @@
+#include "pixel_map.h"
+
+PixelMap::PixelMap(int physical_width, int physical_height)
+    : physical_width(physical_width), physical_height(physical_height),
+      visible_width(physical_width), visible_height(physical_height),
+      table(static_cast<size_t>(physical_width) * physical_height) {
+    for (uint32_t i = 0; i < table.size(); ++i) {
+        table[i] = i;
+    }
+}
+
+bool PixelMap::Apply(const rgb_matrix::PixelMapper *mapper) {
+    if (!mapper) {
+        return false;
+    }
+
+    int new_width = 0;
+    int new_height = 0;
+    if (!mapper->GetSizeMapping(visible_width, visible_height, &new_width, &new_height)) {
+        return false;
+    }
+
+    // Each new visible pixel maps into the previous visible space, whose
+    // table already resolves to the physical layout
+    std::vector<uint32_t> composed(static_cast<size_t>(new_width) * new_height, UNMAPPED);
+    for (int y = 0; y < new_height; ++y) {
+        for (int x = 0; x < new_width; ++x) {
+            int matrix_x = -1;
+            int matrix_y = -1;
+            mapper->MapVisibleToMatrix(visible_width, visible_height, x, y, &matrix_x, &matrix_y);
+            if (matrix_x < 0 || matrix_y < 0 || matrix_x >= visible_width || matrix_y >= visible_height) {
+                continue;
+            }
+            composed[static_cast<size_t>(y) * new_width + x] = index(matrix_x, matrix_y);
+        }
+    }
+
+    table = std::move(composed);
+    visible_width = new_width;
+    visible_height = new_height;
+    return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "pixel-mapper.h"
+
+/**
+ * Flattened pixel mapper chain: a table from visible pixel to physical
+ * framebuffer index.
+ *
+ * Mappers are composed once when they're applied, the same way RGBMatrix
+ * builds its pixel designator map, so resolving a pixel is one table lookup
+ * no matter how many mappers are stacked.
+ */
+struct PixelMap {
+public:
+    static constexpr uint32_t UNMAPPED = UINT32_MAX;
+
+    /**
+     * Create an identity map for a panel chain.
+     * @param physical_width Width of the panel chain in pixels
+     * @param physical_height Height of the panel chain in pixels
+     */
+    PixelMap(int physical_width, int physical_height);
+
+    /**
+     * Compose a pixel mapper on top of the current geometry.
+     * @param mapper Mapper from rgb_matrix::FindPixelMapper (not owned)
+     * @return true if the mapper accepted the current geometry
+     */
+    bool Apply(const rgb_matrix::PixelMapper *mapper);
+
+    int width() const { return visible_width; }
+    int height() const { return visible_height; }
+    int physicalWidth() const { return physical_width; }
+    int physicalHeight() const { return physical_height; }
+
+    /**
+     * Physical pixel index (y * physicalWidth() + x) of a visible pixel, or
+     * UNMAPPED. The caller keeps x and y inside width() and height().
+     */
+    uint32_t index(int x, int y) const { return table[static_cast<size_t>(y) * visible_width + x]; }
+
+    /**
+     * Table row for visible row y, width() entries.
+     */
+    const uint32_t *row(int y) const { return &table[static_cast<size_t>(y) * visible_width]; }
+
+private:
+    int physical_width;
+    int physical_height;
+    int visible_width;
+    int visible_height;
+    std::vector<uint32_t> table;
+};
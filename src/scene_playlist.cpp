@@ -0,0 +1,183 @@
+#include "scene_playlist.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include "sign.h"
+
+ScenePlaylist::ScenePlaylist(Sign &sign, std::string path) : sign(sign), path(std::move(path)) {}
+
+ScenePlaylist::~ScenePlaylist() {
+    stop();
+}
+
+void ScenePlaylist::load() {
+    std::ifstream in(path);
+    std::string line;
+    bool resume = false;
+    if (std::getline(in, line)) {
+        resume = line == "PLAYING";
+    }
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        // <duration_ms> <fade_ms> <config>
+        size_t first = line.find(' ');
+        size_t second = first == std::string::npos ? first : line.find(' ', first + 1);
+        std::string_view view(line);
+        size_t duration_ms, fade_ms;
+        if (second == std::string::npos || !safeParseUInt(view.substr(0, first), duration_ms) ||
+            !safeParseUInt(view.substr(first + 1, second - first - 1), fade_ms) || duration_ms > UINT32_MAX ||
+            fade_ms > UINT32_MAX ||
+            !insert(static_cast<uint32_t>(duration_ms), static_cast<uint32_t>(fade_ms), view.substr(second + 1))) {
+            fprintf(stderr, "Skipping malformed playlist entry: %s\n", line.c_str());
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    printf("Loaded %zu playlist scenes from %s\n", entries.size(), path.c_str());
+    if (resume && !entries.empty()) {
+        restart();
+    }
+}
+
+void ScenePlaylist::start() {
+    if (thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = false;
+    }
+    thread = std::thread(&ScenePlaylist::run, this);
+}
+
+void ScenePlaylist::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+bool ScenePlaylist::add(uint32_t duration_ms, uint32_t fade_ms, std::string_view config) {
+    if (!insert(duration_ms, fade_ms, config)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    save();
+    return true;
+}
+
+bool ScenePlaylist::insert(uint32_t duration_ms, uint32_t fade_ms, std::string_view config) {
+    if (duration_ms == 0 || fade_ms > duration_ms) {
+        return false;
+    }
+    Scene scene = parseSignConfig(config);
+    if (scene.renderables.empty()) {
+        fprintf(stderr, "Invalid playlist scene: %.*s\n", static_cast<int>(config.size()), config.data());
+        return false;
+    }
+    scene.fade_ms = static_cast<int>(fade_ms);
+
+    // Prepare outside the lock; the rotation only ever copies prepared scenes
+    sign.prepareScene(scene);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.push_back(Entry{std::move(scene), std::chrono::milliseconds(duration_ms), fade_ms, std::string(config)});
+    return true;
+}
+
+bool ScenePlaylist::play() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (entries.empty()) {
+            return false;
+        }
+        restart();
+        save();
+    }
+    wake.notify_one();
+    return true;
+}
+
+void ScenePlaylist::restart() {
+    playing = true;
+    position = 0;
+    next.reset();
+    switch_time = Clock::now();
+}
+
+void ScenePlaylist::pause() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!playing) {
+        return; // Every client publish lands here; don't rewrite the file each time
+    }
+    playing = false;
+    next.reset();
+    save();
+}
+
+void ScenePlaylist::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    playing = false;
+    entries.clear();
+    position = 0;
+    next.reset();
+    save();
+}
+
+size_t ScenePlaylist::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+void ScenePlaylist::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        if (!playing) {
+            wake.wait(lock);
+            continue;
+        }
+
+        // Get the next scene ready while the current one is still showing
+        if (!next) {
+            next = std::make_unique<Scene>(entries[position].scene);
+        }
+        if (Clock::now() < switch_time) {
+            wake.wait_until(lock, switch_time);
+            continue;
+        }
+
+        // Deadlines advance from the planned switch time so the rotation
+        // doesn't drift, unless it fell behind by more than an entry
+        auto scene = std::move(next);
+        switch_time += entries[position].duration;
+        if (switch_time < Clock::now()) {
+            switch_time = Clock::now() + entries[position].duration;
+        }
+        position = (position + 1) % entries.size();
+
+        // Published under the lock, so once pause() returns no rotation
+        // scene can land on top of the one that paused it
+        sign.publishPlaylistScene(std::move(scene));
+    }
+}
+
+void ScenePlaylist::save() const {
+    // Write a new file and move it over the old one so a crash never leaves half a playlist
+    const std::string temp_path = path + ".tmp";
+    std::ofstream out(temp_path, std::ios::trunc);
+    out << (playing ? "PLAYING" : "STOPPED") << '\n';
+    for (const auto &entry : entries) {
+        out << entry.duration.count() << ' ' << entry.fade_ms << ' ' << entry.config << '\n';
+    }
+    out.close();
+    if (!out || rename(temp_path.c_str(), path.c_str()) != 0) {
+        fprintf(stderr, "Failed to write %s\n", path.c_str());
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "parsecommand.h"
+
+struct Sign;
+
+/**
+ * Scenes shown in rotation by the daemon, each for a set time.
+ *
+ * Every entry is parsed and prepared when it is added. While one entry
+ * plays, a copy of the next one is made ahead of time, so a switch is a
+ * publish and the render thread never waits on parsing or fonts. An entry
+ * either cuts to its scene or cross-fades into it from the previous picture.
+ *
+ * Any other scene outranks the rotation: a client's SET, CLEAR, SHM, frame or
+ * ACTIVATE, a scheduled scene firing or a template being shown pauses the
+ * playlist before it goes up, as PLAYLIST STOP would. The rotation stays
+ * paused, across restarts too, until PLAYLIST START.
+ *
+ * The entries and whether the rotation runs are persisted, one
+ * "<duration_ms> <fade_ms> <config>" line per entry after a PLAYING or
+ * STOPPED line, and reloaded at startup.
+ */
+struct ScenePlaylist {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @param sign Sign to publish scenes to
+     * @param path File the playlist is persisted in
+     */
+    ScenePlaylist(Sign &sign, std::string path);
+    ~ScenePlaylist();
+
+    /**
+     * Load the persisted playlist and resume the rotation if it was running.
+     * Entries that fail to parse are skipped.
+     */
+    void load();
+
+    void start();
+    void stop();
+
+    /**
+     * Append an entry. The rotation picks it up on its next pass.
+     * @param duration_ms How long the scene is shown, including its fade
+     * @param fade_ms Cross-fade into the scene over this long, 0 to cut
+     * @param config Scene in the SET format
+     * @return false if the scene is invalid or the fade outlasts the entry
+     */
+    bool add(uint32_t duration_ms, uint32_t fade_ms, std::string_view config);
+
+    /**
+     * Start rotating from the first entry.
+     * @return false if the playlist is empty
+     */
+    bool play();
+
+    /**
+     * Stop rotating. The scene on display stays up. Does nothing, and writes
+     * nothing, if the rotation is already stopped.
+     */
+    void pause();
+
+    /**
+     * Stop rotating and remove all entries.
+     */
+    void clear();
+
+    size_t size() const;
+
+private:
+    struct Entry {
+        Scene scene; // Prepared master copy, never drawn
+        std::chrono::milliseconds duration;
+        uint32_t fade_ms;
+        std::string config;
+    };
+
+    bool insert(uint32_t duration_ms, uint32_t fade_ms, std::string_view config);
+    void restart();
+    void run();
+    void save() const;
+
+    Sign &sign;
+    std::string path;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    bool playing = false;
+    std::vector<Entry> entries;
+    size_t position = 0;            // Entry shown at the next switch
+    std::unique_ptr<Scene> next;    // Its copy, made while the current one plays
+    Clock::time_point switch_time;  // When the next entry goes up
+    std::thread thread;
+};
@@ -0,0 +1,326 @@
+#include "scene_scheduler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+
+#include "sign.h"
+
+namespace {
+// Next space-separated word of spec, advancing pos past it
+std::string_view nextWord(std::string_view spec, size_t &pos) {
+    size_t start = spec.find_first_not_of(' ', pos);
+    if (start == std::string_view::npos) {
+        pos = spec.size();
+        return {};
+    }
+    size_t end = spec.find(' ', start);
+    if (end == std::string_view::npos) {
+        end = spec.size();
+    }
+    pos = end;
+    return spec.substr(start, end - start);
+}
+
+bool parseWeekdays(std::string_view days, uint8_t &mask) {
+    mask = 0;
+    size_t pos = 0;
+    while (pos <= days.size()) {
+        size_t comma = days.find(',', pos);
+        if (comma == std::string_view::npos) {
+            comma = days.size();
+        }
+        size_t day;
+        if (!safeParseUInt(days.substr(pos, comma - pos), day) || day > 6) {
+            return false;
+        }
+        mask |= static_cast<uint8_t>(1u << day);
+        pos = comma + 1;
+    }
+    return mask != 0;
+}
+
+bool parseTimeOfDay(std::string_view time, int &minute) {
+    size_t colon = time.find(':');
+    size_t hours, minutes;
+    if (colon == std::string_view::npos || !safeParseUInt(time.substr(0, colon), hours) ||
+        !safeParseUInt(time.substr(colon + 1), minutes) || hours > 23 || minutes > 59) {
+        return false;
+    }
+    minute = static_cast<int>(hours * 60 + minutes);
+    return true;
+}
+
+SceneScheduler::Clock::time_point toTimePoint(int64_t seconds) {
+    return SceneScheduler::Clock::time_point(std::chrono::seconds(seconds));
+}
+
+int64_t unixNow() {
+    return std::chrono::duration_cast<std::chrono::seconds>(SceneScheduler::Clock::now().time_since_epoch()).count();
+}
+}
+
+bool parseScheduleEntry(std::string_view spec, ScheduleEntry &entry) {
+    size_t pos = 0;
+    size_t id;
+    if (!safeParseUInt(nextWord(spec, pos), id) || id > UINT32_MAX) {
+        return false;
+    }
+    entry.id = static_cast<uint32_t>(id);
+
+    std::string_view kind = nextWord(spec, pos);
+    if (kind == "ONCE") {
+        size_t at;
+        if (!safeParseUInt(nextWord(spec, pos), at)) {
+            return false;
+        }
+        entry.weekly = false;
+        entry.at = static_cast<int64_t>(at);
+    } else if (kind == "WEEKLY") {
+        if (!parseWeekdays(nextWord(spec, pos), entry.weekdays) || !parseTimeOfDay(nextWord(spec, pos), entry.minute)) {
+            return false;
+        }
+        entry.weekly = true;
+    } else {
+        return false;
+    }
+
+    // The rest of the line is the scene: a template reference, or a config
+    // which may contain spaces
+    size_t scene_pos = pos;
+    size_t template_id;
+    entry.from_template = nextWord(spec, scene_pos) == "TEMPLATE";
+    if (entry.from_template) {
+        if (!safeParseUInt(nextWord(spec, scene_pos), template_id) || template_id > UINT32_MAX ||
+            !nextWord(spec, scene_pos).empty()) {
+            return false;
+        }
+        entry.template_id = static_cast<uint32_t>(template_id);
+        entry.config.clear();
+        return true;
+    }
+    if (pos < spec.size()) {
+        ++pos;
+    }
+    entry.config = std::string(spec.substr(pos));
+    return true;
+}
+
+std::string formatScheduleEntry(const ScheduleEntry &entry) {
+    std::string spec = std::to_string(entry.id);
+    if (entry.weekly) {
+        spec += " WEEKLY ";
+        bool first = true;
+        for (int day = 0; day < 7; ++day) {
+            if (entry.weekdays & (1u << day)) {
+                spec += first ? "" : ",";
+                spec += std::to_string(day);
+                first = false;
+            }
+        }
+        char time[16];
+        snprintf(time, sizeof(time), " %02d:%02d", entry.minute / 60, entry.minute % 60);
+        spec += time;
+    } else {
+        spec += " ONCE " + std::to_string(entry.at);
+    }
+    if (entry.from_template) {
+        return spec + " TEMPLATE " + std::to_string(entry.template_id);
+    }
+    return spec + " " + entry.config;
+}
+
+int64_t nextFireTime(const ScheduleEntry &entry, int64_t after) {
+    if (!entry.weekly) {
+        return entry.at > after ? entry.at : -1;
+    }
+
+    // Walk local calendar days; mktime normalizes the day overflow and DST
+    time_t base = static_cast<time_t>(after);
+    struct tm today;
+    localtime_r(&base, &today);
+    for (int offset = 0; offset <= 7; ++offset) {
+        struct tm day = today;
+        day.tm_mday += offset;
+        day.tm_hour = entry.minute / 60;
+        day.tm_min = entry.minute % 60;
+        day.tm_sec = 0;
+        day.tm_isdst = -1;
+        time_t candidate = mktime(&day);
+        int weekday = (day.tm_wday + 6) % 7; // tm_wday counts from Sunday
+        if (candidate > base && (entry.weekdays & (1u << weekday))) {
+            return static_cast<int64_t>(candidate);
+        }
+    }
+    return -1;
+}
+
+SceneScheduler::SceneScheduler(Sign &sign, std::string path) : sign(sign), path(std::move(path)) {}
+
+SceneScheduler::~SceneScheduler() {
+    stop();
+}
+
+void SceneScheduler::load() {
+    std::ifstream in(path);
+    std::string line;
+    int64_t now = unixNow();
+    std::lock_guard<std::mutex> lock(mutex);
+    while (std::getline(in, line)) {
+        ScheduleEntry entry;
+        if (line.empty()) {
+            continue;
+        }
+        if (!parseScheduleEntry(line, entry)) {
+            fprintf(stderr, "Skipping malformed schedule entry: %s\n", line.c_str());
+            continue;
+        }
+        insert(entry, now); // Passed one-shot entries are dropped here
+    }
+    printf("Loaded %zu scheduled scenes from %s\n", jobs.size(), path.c_str());
+}
+
+void SceneScheduler::start() {
+    if (thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = false;
+    }
+    thread = std::thread(&SceneScheduler::run, this);
+}
+
+void SceneScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+bool SceneScheduler::add(const ScheduleEntry &entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!insert(entry, unixNow())) {
+        return false;
+    }
+    save();
+    wake.notify_one(); // The new entry may be the earliest
+    return true;
+}
+
+bool SceneScheduler::insert(const ScheduleEntry &entry, int64_t now) {
+    int64_t next = nextFireTime(entry, now);
+    if (next < 0) {
+        return false;
+    }
+
+    // Parse and prepare now so firing is only a copy and a publish; a
+    // template is looked up when it fires, so later uploads take effect
+    Scene scene;
+    if (!entry.from_template) {
+        scene = parseSignConfig(entry.config);
+        if (scene.renderables.empty() && !entry.config.empty()) {
+            fprintf(stderr, "Invalid scene for schedule entry %u\n", entry.id);
+            return false;
+        }
+        sign.prepareScene(scene);
+    }
+
+    auto existing = jobs.find(entry.id);
+    if (existing != jobs.end()) {
+        timers.erase(existing->second.timer);
+        jobs.erase(existing);
+    }
+    Job &job = jobs[entry.id];
+    job.entry = entry;
+    job.scene = std::move(scene);
+    job.timer = timers.emplace(toTimePoint(next), entry.id);
+    return true;
+}
+
+bool SceneScheduler::remove(uint32_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = jobs.find(id);
+    if (it == jobs.end()) {
+        return false;
+    }
+    timers.erase(it->second.timer);
+    jobs.erase(it);
+    save();
+    return true;
+}
+
+void SceneScheduler::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    timers.clear();
+    jobs.clear();
+    save();
+}
+
+size_t SceneScheduler::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return jobs.size();
+}
+
+void SceneScheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        if (timers.empty()) {
+            wake.wait(lock);
+            continue;
+        }
+        // Re-check after every wake: entries may have changed meanwhile
+        auto due = timers.begin()->first;
+        if (Clock::now() < due) {
+            wake.wait_until(lock, due);
+            continue;
+        }
+
+        uint32_t id = timers.begin()->second;
+        timers.erase(timers.begin());
+        auto it = jobs.find(id);
+        const bool from_template = it->second.entry.from_template;
+        const uint32_t template_id = it->second.entry.template_id;
+        std::unique_ptr<Scene> scene;
+        if (!from_template) {
+            scene = std::make_unique<Scene>(it->second.scene);
+        }
+
+        // Occurrences missed while the system was suspended collapse into this one
+        int64_t fired = std::chrono::duration_cast<std::chrono::seconds>(due.time_since_epoch()).count();
+        int64_t next = nextFireTime(it->second.entry, std::max(fired, unixNow()));
+        if (next < 0) {
+            jobs.erase(it);
+            save();
+        } else {
+            it->second.timer = timers.emplace(toTimePoint(next), id);
+        }
+
+        lock.unlock();
+        printf("Scheduled scene %u fired\n", id);
+        if (!from_template) {
+            sign.publishScene(std::move(scene));
+        } else if (!sign.templates || !sign.templates->activate(sign, template_id)) {
+            fprintf(stderr, "Scheduled scene %u: no template %u\n", id, template_id);
+        }
+        lock.lock();
+    }
+}
+
+void SceneScheduler::save() const {
+    // Write a new file and move it over the old one so a crash never leaves half a schedule
+    const std::string temp_path = path + ".tmp";
+    std::ofstream out(temp_path, std::ios::trunc);
+    for (const auto &job : jobs) {
+        out << formatScheduleEntry(job.second.entry) << '\n';
+    }
+    out.close();
+    if (!out || rename(temp_path.c_str(), path.c_str()) != 0) {
+        fprintf(stderr, "Failed to write %s\n", path.c_str());
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "parsecommand.h"
+
+struct Sign;
+
+/**
+ * When and what a scheduled scene shows. As text (SCHEDULE ADD and the
+ * schedule file) an entry is one of
+ *   "<id> ONCE <unix_seconds> <scene>"
+ *   "<id> WEEKLY <days> <HH:MM> <scene>"
+ * where days is a comma-separated list with 0 = Monday ... 6 = Sunday, as
+ * stored by the web app, and scene is either "TEMPLATE <template_id>", which
+ * activates that scene template when the entry fires, or a scene config in
+ * the SET format.
+ */
+struct ScheduleEntry {
+    uint32_t id = 0;
+    bool weekly = false;
+    int64_t at = 0;       // ONCE: Unix time in seconds
+    uint8_t weekdays = 0; // WEEKLY: bit 0 = Monday ... bit 6 = Sunday
+    int minute = 0;       // WEEKLY: local time in minutes after midnight
+    bool from_template = false;
+    uint32_t template_id = 0; // Template activated when from_template is set
+    std::string config;       // Scene shown otherwise
+};
+
+/**
+ * Parse an entry from its text form.
+ * @return true if the entry is well formed (the config is not checked)
+ */
+bool parseScheduleEntry(std::string_view spec, ScheduleEntry &entry);
+
+/**
+ * Format an entry in the text form parseScheduleEntry() reads.
+ */
+std::string formatScheduleEntry(const ScheduleEntry &entry);
+
+/**
+ * Next time an entry fires, strictly after a given time.
+ * @param after Unix time in seconds
+ * @return Unix time in seconds, or -1 if the entry never fires again
+ */
+int64_t nextFireTime(const ScheduleEntry &entry, int64_t after);
+
+/**
+ * Scenes published at scheduled times by the daemon itself.
+ *
+ * Entries naming a template activate it when they fire, so the template
+ * store stays the one copy of that scene. Other entries' scenes are parsed
+ * and prepared when they are added. A thread sleeps until the earliest
+ * deadline in a time-ordered timer queue, so a switch costs a scene copy
+ * and a publish. Entries are persisted to a file
+ * and reloaded at startup; one-shot entries that passed while the daemon
+ * was down are dropped.
+ */
+struct SceneScheduler {
+public:
+    using Clock = std::chrono::system_clock;
+
+    /**
+     * @param sign Sign to publish scenes to
+     * @param path File the entries are persisted in
+     */
+    SceneScheduler(Sign &sign, std::string path);
+    ~SceneScheduler();
+
+    /**
+     * Load the persisted entries. Entries that fail to parse are skipped.
+     */
+    void load();
+
+    void start();
+    void stop();
+
+    /**
+     * Add an entry, replacing any entry with the same id.
+     * @return false if the entry or its scene is invalid, or it never fires
+     */
+    bool add(const ScheduleEntry &entry);
+
+    /**
+     * @return false if there was no entry with that id
+     */
+    bool remove(uint32_t id);
+
+    void clear();
+
+    size_t size() const;
+
+private:
+    struct Job {
+        ScheduleEntry entry;
+        Scene scene;
+        std::multimap<Clock::time_point, uint32_t>::iterator timer;
+    };
+
+    bool insert(const ScheduleEntry &entry, int64_t now);
+    void run();
+    void save() const;
+
+    Sign &sign;
+    std::string path;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::map<uint32_t, Job> jobs;
+    std::multimap<Clock::time_point, uint32_t> timers; // Next fire time -> job id
+    std::thread thread;
+};
@@ -0,0 +1,101 @@
+#include "scene_templates.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include "sign.h"
+
+SceneTemplates::SceneTemplates(std::string path) : path(std::move(path)) {}
+
+void SceneTemplates::load(Sign &sign) {
+    std::ifstream in(path);
+    std::string line;
+    std::lock_guard<std::mutex> lock(mutex);
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        size_t space = line.find(' ');
+        size_t id;
+        if (space == std::string::npos || !safeParseUInt(std::string_view(line).substr(0, space), id) ||
+            id > UINT32_MAX || !insert(sign, static_cast<uint32_t>(id), std::string_view(line).substr(space + 1))) {
+            fprintf(stderr, "Skipping malformed template: %s\n", line.c_str());
+        }
+    }
+    printf("Loaded %zu scene templates from %s\n", templates.size(), path.c_str());
+}
+
+bool SceneTemplates::store(Sign &sign, uint32_t id, std::string_view config) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!insert(sign, id, config)) {
+        return false;
+    }
+    save();
+    return true;
+}
+
+bool SceneTemplates::insert(Sign &sign, uint32_t id, std::string_view config) {
+    Scene scene = parseSignConfig(config);
+    if (scene.renderables.empty()) {
+        fprintf(stderr, "Invalid scene for template %u\n", id);
+        return false;
+    }
+    sign.prepareScene(scene);
+
+    Template &entry = templates[id];
+    entry.config = std::string(config);
+    entry.scene = std::move(scene);
+    entry.next = std::make_unique<Scene>(entry.scene);
+    return true;
+}
+
+bool SceneTemplates::remove(uint32_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (templates.erase(id) == 0) {
+        return false;
+    }
+    save();
+    return true;
+}
+
+bool SceneTemplates::activate(Sign &sign, uint32_t id) {
+    std::unique_ptr<Scene> scene;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = templates.find(id);
+        if (it == templates.end()) {
+            return false;
+        }
+        scene = std::move(it->second.next);
+        if (!scene) {
+            scene = std::make_unique<Scene>(it->second.scene); // Activated again before the copy was made
+        }
+    }
+    sign.publishScene(std::move(scene));
+
+    // Make the copy for the next activation once the switch is done
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = templates.find(id);
+    if (it != templates.end() && !it->second.next) {
+        it->second.next = std::make_unique<Scene>(it->second.scene);
+    }
+    return true;
+}
+
+size_t SceneTemplates::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return templates.size();
+}
+
+void SceneTemplates::save() const {
+    // Write a new file and move it over the old one so a crash never leaves half the templates
+    const std::string temp_path = path + ".tmp";
+    std::ofstream out(temp_path, std::ios::trunc);
+    for (const auto &entry : templates) {
+        out << entry.first << ' ' << entry.second.config << '\n';
+    }
+    out.close();
+    if (!out || rename(temp_path.c_str(), path.c_str()) != 0) {
+        fprintf(stderr, "Failed to write %s\n", path.c_str());
+    }
+}
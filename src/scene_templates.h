@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "parsecommand.h"
+
+struct Sign;
+
+/**
+ * Scenes uploaded once under an ID and shown later by ID.
+ *
+ * A template is parsed and prepared (fonts resolved, text rasterized) when
+ * it is stored. Each template also keeps a ready copy of its scene, so
+ * activating it hands that copy to the render thread without parsing or
+ * copying; the next copy is made after the switch. Templates are persisted
+ * as "<id> <config>" lines and reloaded at startup.
+ */
+struct SceneTemplates {
+public:
+    explicit SceneTemplates(std::string path);
+
+    /**
+     * Load the persisted templates. Lines that fail to parse are skipped.
+     */
+    void load(Sign &sign);
+
+    /**
+     * Parse, prepare and store a template, replacing any with the same ID.
+     * @param config Scene in the SET format
+     * @return false if the scene is invalid
+     */
+    bool store(Sign &sign, uint32_t id, std::string_view config);
+
+    /**
+     * @return false if there was no template with that ID
+     */
+    bool remove(uint32_t id);
+
+    /**
+     * Publish a template's scene.
+     * @return false if there is no template with that ID
+     */
+    bool activate(Sign &sign, uint32_t id);
+
+    size_t size() const;
+
+private:
+    struct Template {
+        std::string config;
+        Scene scene;                 // Prepared master copy, never drawn
+        std::unique_ptr<Scene> next; // Copy handed out by the next activation
+    };
+
+    bool insert(Sign &sign, uint32_t id, std::string_view config);
+    void save() const;
+
+    std::string path;
+    mutable std::mutex mutex;
+    std::map<uint32_t, Template> templates;
+};
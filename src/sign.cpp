@@ -1,11 +1,14 @@
 #include "sign.h"
 #include "constants.h"
 #include "pixel-mapper.h"
+#include "utf8.h"
+#include <algorithm>
 #include <sstream>
 #include <cctype>
-#include <unistd.h>
 #include <memory>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
 
 
 
@@ -13,8 +16,12 @@
 Sign::Sign() {}
 
 Sign::~Sign() {
-    // Ensure interruption is set to stop any running render loops
-    interrupt_received = true;
+    // Stop the render thread and drop any scene it never picked up
+    stopScheduler();
+    stopPlaylist();
+    closeFrameRing();
+    stop();
+    delete pending_scene.exchange(nullptr);
     
     // Clear the canvas if it exists
     if (canvas) {
@@ -22,7 +29,36 @@ Sign::~Sign() {
     }
 }
 
-SignError Sign::Initialize() {
+SignError Sign::Initialize(CanvasBackend backend) {
+    this->backend = backend;
+
+    // Index font files; they're parsed when a scene first uses them unless
+    // the font pack already has their atlases
+    bool have_files = scanFonts();
+    bool have_pack = loadFontPack(LedSignConstants::FONT_PACK_PATH);
+    if (!have_files && !have_pack) {
+        fprintf(stderr, "Failed to find fonts\n");
+        return SignError::FONT_LOAD_ERROR;
+    }
+
+    // Set default font
+    current_font = getAtlas(LedSignConstants::DEFAULT_FONT);
+    if (!current_font) {
+        fprintf(stderr, "Default font %s not found\n", LedSignConstants::DEFAULT_FONT);
+        return SignError::FONT_LOAD_ERROR;
+    }
+    current_font_name = LedSignConstants::DEFAULT_FONT;
+
+    // Load what the last scene used so it shows without parse stalls after a restart
+    prewarmFonts();
+
+    if (backend == CanvasBackend::OFFSCREEN) {
+        return createOffscreenCanvas();
+    }
+    return createHardwareCanvas();
+}
+
+SignError Sign::createHardwareCanvas() {
     RGBMatrix::Options matrix_options;
     rgb_matrix::RuntimeOptions runtime_opt;
 
@@ -33,44 +69,69 @@ SignError Sign::Initialize() {
     matrix_options.parallel = LedSignConstants::LED_PARALLEL;
     matrix_options.disable_hardware_pulsing = LedSignConstants::DISABLE_HARDWARE_PULSING;
 
-    // Load all fonts into cache
-    if (!loadAllFonts()) {
-        fprintf(stderr, "Failed to load fonts\n");
-        return SignError::FONT_LOAD_ERROR;
-    }
-
-    // Set default font
-    const rgb_matrix::Font* default_font = getFont("6x10");
-    if (default_font) {
-        current_font = *default_font;
-    } else {
-        fprintf(stderr, "Default font 6x10 not found\n");
-        return SignError::FONT_LOAD_ERROR;
-    }
-
-    auto p = rgb_matrix::FindPixelMapper("U-mapper",4,1);
-    auto p2 = rgb_matrix::FindPixelMapper("Rotate",4,1,"180");
+    auto p = rgb_matrix::FindPixelMapper(LedSignConstants::PIXEL_MAPPER, LedSignConstants::LED_CHAIN, LedSignConstants::LED_PARALLEL);
+    auto p2 = rgb_matrix::FindPixelMapper(LedSignConstants::ROTATE_MAPPER, LedSignConstants::LED_CHAIN, LedSignConstants::LED_PARALLEL, LedSignConstants::ROTATE_MAPPER_ANGLE);
 
     if (!p) {
         fprintf(stderr, "Failed to create pixel mapper\n");
         return SignError::PIXEL_MAPPER_ERROR;
     }
 
-    this->canvas = std::shared_ptr<RGBMatrix>(RGBMatrix::CreateFromOptions(matrix_options, runtime_opt));
+    RGBMatrix* hardware = RGBMatrix::CreateFromOptions(matrix_options, runtime_opt);
   
-    if (!canvas) {
+    if (!hardware) {
         fprintf(stderr, "Failed to create RGB matrix. Check hardware configuration and permissions.\n");
         return SignError::MATRIX_CREATION_ERROR;
     }
+    this->canvas = std::shared_ptr<rgb_matrix::Canvas>(hardware);
+    this->matrix = hardware;
 
-    if (!this->canvas->ApplyPixelMapper(p)) {
+    if (!hardware->ApplyPixelMapper(p)) {
         fprintf(stderr, "Failed to apply pixel mapper to canvas\n");
         return SignError::PIXEL_MAPPER_APPLY_ERROR;
     }
-    if (!this->canvas->ApplyPixelMapper(p2)) {
+    if (!hardware->ApplyPixelMapper(p2)) {
         fprintf(stderr, "Failed to apply pixel mapper 2 to canvas\n");
         return SignError::PIXEL_MAPPER_APPLY_ERROR;
     }
+
+    // Offscreen frame for double buffering; created after the mappers so it
+    // shares the mapped geometry
+    this->matrix_back_buffer = hardware->CreateFrameCanvas();
+    if (!matrix_back_buffer) {
+        fprintf(stderr, "Failed to create frame canvas\n");
+        return SignError::MATRIX_CREATION_ERROR;
+    }
+    this->back_buffer = matrix_back_buffer;
+    return SignError::SUCCESS;
+}
+
+SignError Sign::createOffscreenCanvas() {
+    auto p = rgb_matrix::FindPixelMapper(LedSignConstants::PIXEL_MAPPER, LedSignConstants::LED_CHAIN, LedSignConstants::LED_PARALLEL);
+    auto p2 = rgb_matrix::FindPixelMapper(LedSignConstants::ROTATE_MAPPER, LedSignConstants::LED_CHAIN, LedSignConstants::LED_PARALLEL, LedSignConstants::ROTATE_MAPPER_ANGLE);
+
+    if (!p || !p2) {
+        fprintf(stderr, "Failed to create pixel mapper\n");
+        return SignError::PIXEL_MAPPER_ERROR;
+    }
+
+    // Front and back buffer share the same geometry
+    std::shared_ptr<OffscreenCanvas> buffers[2];
+    for (auto &framebuffer : buffers) {
+        framebuffer = std::make_shared<OffscreenCanvas>(
+            LedSignConstants::LED_COLS * LedSignConstants::LED_CHAIN,
+            LedSignConstants::LED_ROWS * LedSignConstants::LED_PARALLEL);
+
+        if (!framebuffer->ApplyPixelMapper(p) || !framebuffer->ApplyPixelMapper(p2)) {
+            fprintf(stderr, "Failed to apply pixel mappers to offscreen canvas\n");
+            return SignError::PIXEL_MAPPER_APPLY_ERROR;
+        }
+    }
+
+    this->offscreen = buffers[0];
+    this->canvas = buffers[0];
+    this->offscreen_back_buffer = buffers[1];
+    this->back_buffer = offscreen_back_buffer.get();
     return SignError::SUCCESS;
 }
 
@@ -80,54 +141,129 @@ void Sign::setFont(const std::string &font_path) {
         return;
     }
 
-    // Extract font name from path for cache lookup
+    // Extract font name from path for cache lookup; a font outside the font
+    // directory is registered under its name so it loads like any other
     std::filesystem::path path(font_path);
     std::string font_name = path.stem().string();
-    
-    // Try to get from cache first
-    const rgb_matrix::Font* cached_font = getFont(font_name);
-    if (cached_font) {
-        current_font = *cached_font;
+    std::lock_guard<std::mutex> lock(font_mutex);
+    bool registered = font_paths.emplace(font_name, font_path).second;
+
+    auto atlas = loadAtlas(font_name);
+    if (!atlas) {
+        fprintf(stderr, "Couldn't load font %s\n", font_path.c_str());
+        if (registered) {
+            font_paths.erase(font_name);
+        }
         return;
     }
+    current_font = atlas;
+    current_font_name = font_name;
+}
 
-    // If not in cache, try to load it directly (fallback)
-    rgb_matrix::Font temp_font;
-    if (!temp_font.LoadFont(font_path.c_str())) {
-        fprintf(stderr, "Couldn't load font %s\n", font_path.c_str());
+void Sign::clear() {
+    // Once started, the render thread owns the buffers; clearing is showing an empty scene
+    if (render_thread.joinable()) {
+        publishScene(std::make_unique<Scene>());
         return;
     }
+    if (!back_buffer) {
+        fprintf(stderr, "Canvas not initialized - cannot clear\n");
+        return;
+    }
+    back_buffer->Clear();
+    present();
+    invalidateFrames();
+}
 
-    // Cache the font and set as current
-    auto font_ptr = std::make_unique<rgb_matrix::Font>();
-    if (font_ptr->LoadFont(font_path.c_str())) {
-        current_font = *font_ptr;
-        font_cache[font_name] = std::move(font_ptr);
-        fonts.push_back(font_path);
+void Sign::present() {
+    if (matrix) {
+        matrix_back_buffer = matrix->SwapOnVSync(matrix_back_buffer, LedSignConstants::VSYNC_FRAMERATE_FRACTION);
+        back_buffer = matrix_back_buffer;
+    } else if (offscreen) {
+        std::swap(offscreen, offscreen_back_buffer);
+        canvas = offscreen;
+        back_buffer = offscreen_back_buffer.get();
     }
 }
 
-void Sign::clear() {
-    if (!canvas) {
-        fprintf(stderr, "Canvas not initialized - cannot clear\n");
+void Sign::drawText(const std::string &text, int x, int y, const rgb_matrix::Color &color, const GlyphAtlas &atlas) const {
+    if (!back_buffer) {
+        fprintf(stderr, "Canvas not initialized - cannot draw text\n");
         return;
     }
-    canvas->Clear();
+
+    // Walk the pen with the atlas advances and only draw glyphs that
+    // intersect [0, width); everything past the right edge is skipped.
+    FrameBuffer *frame_target = frameTarget();
+    const int canvas_width = back_buffer->width();
+    const int cell_width = atlas.cellWidth();
+    const char *it = text.data();
+    const char *end = it + text.size();
+    int pen = x;
+
+    while (it < end && pen < canvas_width) {
+        int glyph = atlas.glyphIndex(utf8NextCodepoint(it, end));
+        if (glyph == GlyphAtlas::NO_GLYPH) {
+            continue;
+        }
+        if (pen + cell_width > 0) {
+            if (frame_target) {
+                frame_target->DrawBits(atlas.glyphBits(glyph), atlas.stride(), 0, pen, y - atlas.baseline(),
+                                       cell_width, atlas.height(), color);
+            } else {
+                atlas.DrawGlyph(back_buffer, pen, y, color, glyph);
+            }
+        }
+        pen += atlas.glyphAdvance(glyph);
+    }
 }
 
-void Sign::drawText(const std::string &text, size_t x, size_t y, const rgb_matrix::Color &color, const rgb_matrix::Font &font) const {
-    if (!canvas) {
+void Sign::drawStrip(const TextStrip &strip, int x, int y, const rgb_matrix::Color &color) const {
+    if (!back_buffer) {
         fprintf(stderr, "Canvas not initialized - cannot draw text\n");
         return;
     }
-    rgb_matrix::DrawText(canvas.get(), font, x, y, rgb_matrix::Color(color.r, color.g, color.b), nullptr, text.c_str());
+    if (FrameBuffer *target = frameTarget()) {
+        strip.Blit(*target, x, y, color);
+        return;
+    }
+    strip.Blit(back_buffer, x, y, color);
+}
+
+void Sign::drawImage(const uint8_t *rgb, int width, int height) const {
+    if (!back_buffer) {
+        fprintf(stderr, "Canvas not initialized - cannot draw image\n");
+        return;
+    }
+    const int visible_width = std::min(width, back_buffer->width());
+    const int visible_height = std::min(height, back_buffer->height());
+
+    // In-memory targets take the whole image a row at a time
+    if (FrameBuffer *target = frameTarget()) {
+        target->Blit(rgb, width, 0, 0, visible_width, visible_height);
+        return;
+    }
+    if (OffscreenCanvas *target = offscreenTarget()) {
+        target->Blit(rgb, width, 0, 0, visible_width, visible_height, false);
+        return;
+    }
+    for (int y = 0; y < visible_height; ++y) {
+        const uint8_t *pixel = rgb + static_cast<size_t>(y) * width * 3;
+        for (int x = 0; x < visible_width; ++x, pixel += 3) {
+            back_buffer->SetPixel(x, y, pixel[0], pixel[1], pixel[2]);
+        }
+    }
+}
+
+OffscreenCanvas *Sign::offscreenTarget() const {
+    return dynamic_cast<OffscreenCanvas *>(back_buffer);
 }
 
-void Sign::handleInterrupt(bool interrupt) {
-    interrupt_received = interrupt;
+FrameBuffer *Sign::frameTarget() const {
+    return dynamic_cast<FrameBuffer *>(back_buffer);
 }
 
-void Sign::setBrightness(int brightness) const {
+void Sign::setBrightness(int brightness) {
     if (!canvas) {
         fprintf(stderr, "Canvas not initialized - cannot set brightness\n");
         return;
@@ -137,85 +273,592 @@ void Sign::setBrightness(int brightness) const {
                 brightness, LedSignConstants::MIN_BRIGHTNESS, LedSignConstants::MAX_BRIGHTNESS);
         return;
     }
-    canvas->SetBrightness(brightness);
+
+    // Once started, the render thread owns the buffers and applies it between frames
+    if (render_thread.joinable()) {
+        pending_brightness = brightness;
+        { std::lock_guard<std::mutex> lock(wake_mutex); }
+        wake_cv.notify_one();
+        return;
+    }
+    applyBrightness(brightness);
+}
+
+void Sign::applyBrightness(int brightness) {
+    // Brightness is applied per frame buffer, so update both sides of the swap
+    if (matrix) {
+        matrix->SetBrightness(brightness);
+        matrix_back_buffer->SetBrightness(brightness);
+    } else if (offscreen) {
+        offscreen->SetBrightness(brightness);
+        offscreen_back_buffer->SetBrightness(brightness);
+    }
+    invalidateFrames();
+}
+
+void Sign::start() {
+    if (render_thread.joinable()) {
+        return;
+    }
+    interrupt_received = false;
+    render_thread = std::thread([this]() { renderLoop(); });
+}
+
+void Sign::stop() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        interrupt_received = true;
+    }
+    wake_cv.notify_one();
+    if (render_thread.joinable()) {
+        render_thread.join();
+    }
+}
+
+void Sign::prepareScene(Scene &scene) {
+    for (auto &item : scene.renderables) {
+        std::visit([this](auto &object) { object.Prepare(*this); }, item);
+    }
+}
+
+void Sign::publishScene(std::unique_ptr<Scene> scene) {
+    // Clients, the scheduler and templates outrank the rotation; pausing
+    // first means the playlist can't put its next scene over this one
+    if (playlist) {
+        playlist->pause();
+    }
+    handOffScene(std::move(scene));
+}
+
+void Sign::publishPlaylistScene(std::unique_ptr<Scene> scene) {
+    handOffScene(std::move(scene));
+}
+
+void Sign::handOffScene(std::unique_ptr<Scene> scene) {
+    // Resolve fonts and rasterize text here so the render thread only draws
+    prepareScene(*scene);
+
+    // Remember the fonts here, off the render thread, for the next boot
+    saveSceneFonts(*scene);
+
+    // Stamp, record the keys and swap in together, so a patch checked against
+    // this scene's keys always finds it in the slot or on display
+    Scene *replaced;
+    {
+        std::lock_guard<std::mutex> lock(patch_mutex);
+        scene->generation = ++scene_generation;
+        scene_keys.clear();
+        for (const auto &item : scene->renderables) {
+            const Renderable &object = itemBase(item);
+            if (!object.key.empty()) {
+                scene_keys.insert(object.key);
+            }
+        }
+        replaced = pending_scene.exchange(scene.release());
+    }
+
+    // Nobody but this call has seen a scene still sitting in the slot, so it
+    // can be freed right away
+    delete replaced;
+
+    // Taking the lock orders the publish with the render thread's wait check
+    { std::lock_guard<std::mutex> lock(wake_mutex); }
+    wake_cv.notify_one();
+}
+
+bool Sign::patchItem(ItemPatch patch) {
+    {
+        std::lock_guard<std::mutex> lock(patch_mutex);
+        if (scene_keys.count(patch.key) == 0) {
+            return false;
+        }
+        pending_patches.emplace_back(scene_generation, std::move(patch));
+    }
+    patches_pending = true;
+    { std::lock_guard<std::mutex> lock(wake_mutex); }
+    wake_cv.notify_one();
+    return true;
+}
+
+void Sign::requestRedraw() {
+    redraw_requested = true;
+    { std::lock_guard<std::mutex> lock(wake_mutex); }
+    wake_cv.notify_one();
+}
+
+bool Sign::openFrameRing() {
+    if (frame_ring) {
+        return true;
+    }
+    auto ring = std::make_shared<FrameRing>();
+    if (!ring->create(LedSignConstants::FRAME_RING_NAME, width, height, LedSignConstants::FRAME_RING_SLOTS)) {
+        fprintf(stderr, "Failed to create frame ring %s\n", LedSignConstants::FRAME_RING_NAME);
+        return false;
+    }
+    frame_ring = std::move(ring);
+    frame_ring_stop = false;
+    frame_ring_thread = std::thread([this]() { frameRingLoop(); });
+    return true;
+}
+
+void Sign::closeFrameRing() {
+    if (!frame_ring) {
+        return;
+    }
+    frame_ring_stop = true;
+    frame_ring->wake();
+    if (frame_ring_thread.joinable()) {
+        frame_ring_thread.join();
+    }
+    // Scenes still showing the ring keep the mapping alive until they're dropped
+    frame_ring.reset();
+}
+
+void Sign::startScheduler(const std::string &path) {
+    if (scheduler) {
+        return;
+    }
+    scheduler = std::make_unique<SceneScheduler>(*this, path);
+    scheduler->load();
+    scheduler->start();
+}
+
+void Sign::stopScheduler() {
+    if (scheduler) {
+        scheduler->stop();
+        scheduler.reset();
+    }
+}
+
+void Sign::loadTemplates(const std::string &path) {
+    templates = std::make_unique<SceneTemplates>(path);
+    templates->load(*this);
+}
+
+void Sign::startPlaylist(const std::string &path) {
+    if (playlist) {
+        return;
+    }
+    playlist = std::make_unique<ScenePlaylist>(*this, path);
+    playlist->load();
+    playlist->start();
+}
+
+void Sign::stopPlaylist() {
+    if (playlist) {
+        playlist->stop();
+        playlist.reset();
+    }
 }
 
-void Sign::render() {
-    // If we have animated objects, start continuous rendering
-    if (hasAnimatedObjects()) {
-        // Continuous render loop for animations
-        while (!interrupt_received) {
+void Sign::frameRingLoop() {
+    uint32_t seen = frame_ring->doorbell();
+    while (!frame_ring_stop) {
+        if (!frame_ring->waitDoorbell(seen, LedSignConstants::FRAME_RING_WAIT_MS)) {
+            continue;
+        }
+        seen = frame_ring->doorbell();
+        if (external_active) {
+            requestRedraw();
+        }
+    }
+}
+
+void Sign::renderLoop() {
+    bool frame_pending = true;
+    uint64_t scene_frames = frame_scheduler.frameCount();
+    uint64_t scene_missed = frame_scheduler.missedDeadlines();
+
+    while (!interrupt_received) {
+        bool was_animated = hasAnimatedObjects() || fading;
+        if (takePendingScene()) {
+            frame_pending = true;
+
+            uint64_t missed = frame_scheduler.missedDeadlines() - scene_missed;
+            if (missed > 0) {
+                printf("Render loop at %d FPS missed %llu of %llu frame deadlines\n", frame_scheduler.targetFps(),
+                       static_cast<unsigned long long>(missed),
+                       static_cast<unsigned long long>(frame_scheduler.frameCount() - scene_frames));
+            }
+            scene_frames = frame_scheduler.frameCount();
+            scene_missed = frame_scheduler.missedDeadlines();
+
+            frame_scheduler.setTargetFps(target_fps);
+            if (!was_animated) {
+                frame_scheduler.reset();
+            }
+        }
+
+        int brightness = pending_brightness.exchange(0);
+        if (brightness != 0) {
+            // Frame buffers hold pixels at the old brightness, so repaint them all
+            applyBrightness(brightness);
+            frame_pending = true;
+        }
+
+        if (applyPendingPatches()) {
+            frame_pending = true;
+        }
+
+        if (redraw_requested.exchange(false)) {
+            static_layer_valid = false;
+            invalidateFrames();
+            frame_pending = true;
+        }
+
+        if (hasAnimatedObjects() || fading) {
+            // Paced against absolute deadlines so render time doesn't stretch the period
             renderFrame();
-            usleep(LedSignConstants::FRAME_DELAY_MICROSECONDS);
+            frame_scheduler.waitForNextFrame();
+            continue;
         }
+
+        // Static content only needs to be drawn once per scene
+        if (frame_pending) {
+            renderFrame();
+            frame_pending = false;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        wake_cv.wait(lock, [this]() {
+            return interrupt_received || pending_scene.load() != nullptr || redraw_requested.load() ||
+                   patches_pending.load() || pending_brightness.load() != 0;
+        });
+    }
+}
+
+bool Sign::takePendingScene() {
+    std::unique_ptr<Scene> next(pending_scene.exchange(nullptr));
+    if (!next) {
+        return false;
+    }
+    // Keep the picture on display to fade from before the scene replaces it
+    if (next->fade_ms > 0) {
+        beginFade(std::chrono::milliseconds(next->fade_ms));
     } else {
-        // Single render for static content
-        renderFrame();
+        fading = false;
+    }
+
+    // The previous renderables are released here, after their last frame
+    live_generation = next->generation;
+    setScene(std::move(*next));
+    return true;
+}
+
+bool Sign::applyPendingPatches() {
+    if (!patches_pending.exchange(false)) {
+        return false;
+    }
+    std::vector<std::pair<uint64_t, ItemPatch>> patches;
+    {
+        std::lock_guard<std::mutex> lock(patch_mutex);
+        patches.swap(pending_patches);
     }
+
+    bool applied = false;
+    std::vector<std::pair<uint64_t, ItemPatch>> held;
+    for (auto &[generation, patch] : patches) {
+        // Sent for a scene that isn't up yet: keep it until takePendingScene()
+        // swaps that scene in. Patches for a scene already replaced are dropped.
+        if (generation > live_generation) {
+            held.emplace_back(generation, std::move(patch));
+            continue;
+        }
+        if (generation < live_generation) {
+            continue;
+        }
+        applied = true;
+        for (size_t i = 0; i < renderables.size(); ++i) {
+            if (itemBase(renderables[i]).key != patch.key) {
+                continue;
+            }
+            std::visit([this, &patch](auto &object) { object.Patch(*this, patch); }, renderables[i]);
+
+            // Animated objects are redrawn every frame anyway, and the area
+            // they covered last frame is restored before that; a static one
+            // is part of the cached layer, which has to be rebuilt
+            if (i < first_animated) {
+                static_layer_valid = false;
+                invalidateFrames();
+            }
+        }
+    }
+
+    if (!held.empty()) {
+        std::lock_guard<std::mutex> lock(patch_mutex);
+        pending_patches.insert(pending_patches.begin(), std::make_move_iterator(held.begin()),
+                               std::make_move_iterator(held.end()));
+        patches_pending = true;
+    }
+    return applied;
 }
 
 void Sign::renderFrame() {
-    // Clear the canvas
-    clear();
+    if (!back_buffer) {
+        fprintf(stderr, "Canvas not initialized - cannot render\n");
+        return;
+    }
     
     // Update timing
     auto now = std::chrono::steady_clock::now();
     last_render_time = now;
-    
-    // Render all objects
-    for (const auto &renderable : renderables) {
-        renderable->Render(*this);
+
+    if (!static_layer_valid) {
+        rebuildStaticLayer();
+    }
+
+    // Compose the frame in memory: erase last frame's animated objects by
+    // restoring the static pixels under them, then draw them again
+    if (!frame_valid) {
+        restoreStaticLayer(Rect{0, 0, frame->width(), frame->height()});
+        frame_valid = true;
+    } else {
+        for (const Rect &rect : frame_rects) {
+            restoreStaticLayer(rect);
+        }
     }
+    frame_rects.clear();
+
+    rgb_matrix::Canvas* target = back_buffer;
+    back_buffer = frame.get();
+    for (size_t i = first_animated; i < renderables.size(); ++i) {
+        std::visit([this](auto &object) {
+            object.Render(*this);
+            Rect dirty = object.Bounds(*this).clipped(frame->width(), frame->height());
+            if (!dirty.empty()) {
+                frame_rects.push_back(dirty);
+            }
+        }, renderables[i]);
+    }
+    back_buffer = target;
+
+    // While cross-fading the whole picture changes every frame, so the blend
+    // is pushed in full and each buffer is marked for a full update after
+    if (fading) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - fade_start);
+        if (elapsed < fade_duration) {
+            const Rect all{0, 0, frame->width(), frame->height()};
+            fade_frame->Blit(fade_from->data(), fade_from->width(), all.x0, all.y0, all.x1, all.y1);
+            fade_frame->Blend(*frame, static_cast<uint8_t>(elapsed.count() * 255 / fade_duration.count()));
+            pushFrame(*fade_frame, all, false);
+
+            BufferState &state = buffer_states[back_buffer];
+            state.valid = true;
+            state.animated_rects.assign(1, all);
+            present();
+            return;
+        }
+        fading = false;
+    }
+
+    // Push only what differs from the frame this back buffer last showed
+    BufferState &state = buffer_states[back_buffer];
+    if (!state.valid) {
+        // First frame of this scene in this buffer - paint everything
+        back_buffer->Clear();
+        pushFrame(*frame, Rect{0, 0, frame->width(), frame->height()}, true);
+        state.valid = true;
+    } else {
+        for (const Rect &rect : state.animated_rects) {
+            pushFrame(*frame, rect, false);
+        }
+        for (const Rect &rect : frame_rects) {
+            pushFrame(*frame, rect, false);
+        }
+    }
+    state.animated_rects = frame_rects;
     
-    // The RGB Matrix library handles double buffering automatically,
-    // but we can add an explicit swap if needed in the future
+    // Publish the finished frame
+    present();
 }
 
-bool Sign::hasAnimatedObjects() const {
-    for (const auto &renderable : renderables) {
-        if (renderable->type == RenderableType::SCROLLING || 
-            renderable->type == RenderableType::ANIMATED) {
-            return true;
+void Sign::rebuildStaticLayer() {
+    const int layer_width = back_buffer->width();
+    const int layer_height = back_buffer->height();
+    if (!static_layer || static_layer->width() != layer_width || static_layer->height() != layer_height) {
+        static_layer = std::make_unique<FrameBuffer>(layer_width, layer_height);
+        frame = std::make_unique<FrameBuffer>(layer_width, layer_height);
+    }
+    static_layer->Clear();
+
+    // Static objects draw through the same helpers, so point them at the layer
+    rgb_matrix::Canvas* target = back_buffer;
+    back_buffer = static_layer.get();
+    for (size_t i = 0; i < first_animated; ++i) {
+        std::visit([this](auto &object) { object.Render(*this); }, renderables[i]);
+    }
+    back_buffer = target;
+    static_layer_valid = true;
+    frame_valid = false;
+}
+
+void Sign::restoreStaticLayer(const Rect &rect) {
+    frame->Blit(static_layer->data(), static_layer->width(), rect.x0, rect.y0, rect.x1, rect.y1);
+}
+
+void Sign::beginFade(std::chrono::milliseconds duration) {
+    // Nothing has been composed yet, so there is nothing to fade from
+    const FrameBuffer *shown = fading ? fade_frame.get() : frame.get();
+    if (!shown || (!fading && !frame_valid)) {
+        fading = false;
+        return;
+    }
+
+    const int fade_width = shown->width();
+    const int fade_height = shown->height();
+    if (!fade_from || fade_from->width() != fade_width || fade_from->height() != fade_height) {
+        fade_from = std::make_unique<FrameBuffer>(fade_width, fade_height);
+        fade_frame = std::make_unique<FrameBuffer>(fade_width, fade_height);
+    }
+    // Fading again mid-fade starts from the blend on display
+    fade_from->Blit(shown->data(), fade_width, 0, 0, fade_width, fade_height);
+    fade_start = std::chrono::steady_clock::now();
+    fade_duration = duration;
+    fading = true;
+}
+
+void Sign::pushFrame(const FrameBuffer &source, const Rect &rect, bool lit_only) {
+    const uint8_t *pixels = source.data();
+    const int stride = source.width();
+    if (OffscreenCanvas *target = offscreenTarget()) {
+        target->Blit(pixels, stride, rect.x0, rect.y0, rect.x1, rect.y1, lit_only);
+        return;
+    }
+
+    // The hardware frame canvas resolves its mappers through the library's own table
+    for (int y = rect.y0; y < rect.y1; ++y) {
+        const uint8_t *pixel = &pixels[(static_cast<size_t>(y) * stride + rect.x0) * 3];
+        for (int x = rect.x0; x < rect.x1; ++x, pixel += 3) {
+            if (lit_only && !(pixel[0] | pixel[1] | pixel[2])) {
+                continue;
+            }
+            back_buffer->SetPixel(x, y, pixel[0], pixel[1], pixel[2]);
         }
     }
-    return false;
 }
 
-void Sign::render(const std::string &config) {
-  this->renderables = parseSignConfig(config);
-  this->render();
+void Sign::setScene(Scene scene) {
+    // Published scenes are prepared already; this covers scenes set directly
+    prepareScene(scene);
+    renderables = std::move(scene.renderables);
+    target_fps = scene.target_fps;
+
+    // Animated objects always draw over the static layer, so grouping them
+    // keeps the picture the same and lets each pass walk only its own range
+    auto animated = std::stable_partition(renderables.begin(), renderables.end(),
+                                          [](const SceneItem &item) { return !itemBase(item).animated(); });
+    first_animated = static_cast<size_t>(animated - renderables.begin());
+
+    bool external = false;
+    for (const auto &item : renderables) {
+        external = external || itemBase(item).type == RenderableType::EXTERNAL;
+    }
+    external_active = external;
+
+    static_layer_valid = false;
+    invalidateFrames();
+}
+
+void Sign::invalidateFrames() {
+    buffer_states.clear();
+    frame_valid = false;
 }
 
-const rgb_matrix::Font* Sign::getFont(const std::string &font_name) const {
+bool Sign::hasAnimatedObjects() const {
+    return first_animated < renderables.size();
+}
+
+void Sign::render(std::string_view config) {
+  this->publishScene(std::make_unique<Scene>(parseSignConfig(config)));
+}
+
+std::shared_ptr<const GlyphAtlas> Sign::getAtlas(const std::string &font_name) {
+    std::lock_guard<std::mutex> lock(font_mutex);
+    return loadAtlas(font_name);
+}
+
+std::shared_ptr<const GlyphAtlas> Sign::currentFont() const {
+    std::lock_guard<std::mutex> lock(font_mutex);
+    return current_font;
+}
+
+std::shared_ptr<const GlyphAtlas> Sign::loadAtlas(const std::string &font_name) {
     auto it = font_cache.find(font_name);
     if (it != font_cache.end()) {
-        return it->second.get();
+        it->second.last_used = ++font_use_clock;
+        return it->second.atlas;
+    }
+
+    // The pack's atlas is used in place, so this is only an index lookup
+    if (auto atlas = font_pack.atlas(font_name)) {
+        return cacheAtlas(font_name, std::move(atlas));
+    }
+
+    // Otherwise parse the .bdf file once for its atlas; the font itself isn't kept
+    auto font = loadFontFile(font_name);
+    if (!font) {
+        return nullptr;
+    }
+    return cacheAtlas(font_name, GlyphAtlas::FromFont(*font));
+}
+
+std::unique_ptr<rgb_matrix::Font> Sign::loadFontFile(const std::string &font_name) {
+    auto path = font_paths.find(font_name);
+    if (path == font_paths.end()) {
+        return nullptr;
+    }
+    auto font = std::make_unique<rgb_matrix::Font>();
+    if (!font->LoadFont(path->second.c_str())) {
+        fprintf(stderr, "Failed to load font: %s\n", path->second.c_str());
+        return nullptr;
     }
-    return nullptr;
+    printf("Loaded font: %s -> %s\n", font_name.c_str(), path->second.c_str());
+    return font;
 }
 
-bool Sign::loadAllFonts() {
-    const std::string font_dir = "./rpi-rgb-led-matrix/fonts/";
+std::shared_ptr<const GlyphAtlas> Sign::cacheAtlas(const std::string &font_name, std::shared_ptr<const GlyphAtlas> atlas) {
+    CachedFont &entry = font_cache[font_name];
+    entry.atlas = std::move(atlas);
+    entry.bytes = entry.atlas->memoryUsage();
+    entry.last_used = ++font_use_clock;
+    font_cache_bytes += entry.bytes;
+
+    evictFonts(font_name);
+    return entry.atlas;
+}
+
+void Sign::evictFonts(const std::string &keep) {
+    while (font_cache_bytes > font_budget_bytes) {
+        auto victim = font_cache.end();
+        for (auto it = font_cache.begin(); it != font_cache.end(); ++it) {
+            if (it->first == keep || it->first == LedSignConstants::DEFAULT_FONT || it->first == current_font_name) {
+                continue;
+            }
+            if (victim == font_cache.end() || it->second.last_used < victim->second.last_used) {
+                victim = it;
+            }
+        }
+        if (victim == font_cache.end()) {
+            return; // Only pinned fonts left
+        }
+        printf("Evicting font: %s\n", victim->first.c_str());
+        font_cache_bytes -= victim->second.bytes;
+        font_cache.erase(victim);
+    }
+}
+
+bool Sign::scanFonts() {
+    const std::string font_dir = LedSignConstants::FONT_DIRECTORY;
     
-    // Clear existing cache
-    font_cache.clear();
-    fonts.clear();
+    // Loaded fonts stay cached; only the index is rebuilt
+    std::lock_guard<std::mutex> lock(font_mutex);
+    font_paths.clear();
     
     try {
         for (const auto &entry : std::filesystem::directory_iterator(font_dir)) {
             if (entry.path().extension() == ".bdf") {
-                std::string font_path = entry.path().string();
                 std::string font_name = entry.path().stem().string(); // filename without extension
-                
-                // Create a new font object
-                auto font = std::make_unique<rgb_matrix::Font>();
-                if (font->LoadFont(font_path.c_str())) {
-                    font_cache[font_name] = std::move(font);
-                    fonts.push_back(font_path);
-                    printf("Loaded font: %s -> %s\n", font_name.c_str(), font_path.c_str());
-                } else {
-                    fprintf(stderr, "Failed to load font: %s\n", font_path.c_str());
-                }
+                font_paths[font_name] = entry.path().string();
             }
         }
     } catch (const std::filesystem::filesystem_error& ex) {
@@ -223,11 +866,63 @@ bool Sign::loadAllFonts() {
         return false;
     }
     
-    if (font_cache.empty()) {
+    if (font_paths.empty()) {
         fprintf(stderr, "No .bdf font files found in %s\n", font_dir.c_str());
         return false;
     }
     
-    printf("Successfully loaded %zu fonts into cache\n", font_cache.size());
+    printf("Found %zu fonts in %s\n", font_paths.size(), font_dir.c_str());
+    return true;
+}
+
+bool Sign::loadFontPack(const std::string &path) {
+    std::lock_guard<std::mutex> lock(font_mutex);
+    if (!font_pack.open(path)) {
+        return false;
+    }
+    printf("Mapped %zu fonts from %s\n", font_pack.fontCount(), path.c_str());
     return true;
 }
+
+void Sign::prewarmFonts() {
+    std::ifstream in(LedSignConstants::SCENE_FONTS_PATH);
+    std::string font_name;
+    while (std::getline(in, font_name)) {
+        if (!font_name.empty() && getAtlas(font_name)) {
+            scene_fonts.push_back(font_name);
+        }
+    }
+    std::sort(scene_fonts.begin(), scene_fonts.end());
+}
+
+void Sign::saveSceneFonts(const Scene &scene) {
+    // Only fonts that actually loaded, so names a client made up never reach
+    // the file; sorted so a rotation between the same scenes doesn't rewrite it
+    std::vector<std::string> fonts;
+    for (const auto &item : scene.renderables) {
+        std::string name = std::visit([](const auto &object) { return object.fontName(); }, item);
+        if (!name.empty()) {
+            fonts.push_back(std::move(name));
+        }
+    }
+    std::sort(fonts.begin(), fonts.end());
+    fonts.erase(std::unique(fonts.begin(), fonts.end()), fonts.end());
+
+    std::lock_guard<std::mutex> lock(scene_fonts_mutex);
+    if (fonts == scene_fonts) {
+        return;
+    }
+    scene_fonts = std::move(fonts);
+
+    // Write a new file and move it over the old one so a crash never leaves a partial list
+    const std::string path = LedSignConstants::SCENE_FONTS_PATH;
+    const std::string temp_path = path + ".tmp";
+    std::ofstream out(temp_path, std::ios::trunc);
+    for (const auto &name : scene_fonts) {
+        out << name << '\n';
+    }
+    out.close();
+    if (!out || rename(temp_path.c_str(), path.c_str()) != 0) {
+        fprintf(stderr, "Failed to write %s\n", path.c_str());
+    }
+}
@@ -2,16 +2,30 @@
 
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <filesystem>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <utility>
+#include <unordered_set>
 #include <vector>
 
 #include "constants.h"
+#include "font_pack.h"
+#include "frame_buffer.h"
+#include "frame_ring.h"
+#include "frame_scheduler.h"
+#include "glyph_atlas.h"
 #include "graphics.h"
 #include "led-matrix.h"
+#include "offscreen_canvas.h"
 #include "parsecommand.h"
+#include "scene_playlist.h"
+#include "scene_scheduler.h"
+#include "scene_templates.h"
 
 using namespace rgb_matrix;
 struct Sign;
@@ -29,23 +43,133 @@ struct Sign {
     size_t width = LedSignConstants::DEFAULT_DISPLAY_WIDTH;
     size_t height = LedSignConstants::DEFAULT_DISPLAY_HEIGHT;
 
+    // Set to stop the render thread
     std::atomic<bool> interrupt_received = false;
 
-    std::vector<std::shared_ptr<Renderable>> renderables;
-    
+    // Scene hand-off: other threads publish a new scene here and the render
+    // thread takes it at the next frame boundary. The replaced scene is freed
+    // on the render thread once it is no longer being drawn.
+    std::atomic<Scene*> pending_scene{nullptr};
+    std::thread render_thread;
+    std::mutex wake_mutex;
+    std::condition_variable wake_cv;
+
+    // Set to repaint the current scene from scratch at the next frame boundary
+    std::atomic<bool> redraw_requested{false};
+
+    // Brightness set while the render thread runs, applied at the next frame boundary (0 = none)
+    std::atomic<int> pending_brightness{0};
+
+    // Item updates from PATCH, applied by the render thread at the next frame
+    // boundary. scene_keys holds the keys of the last published scene so
+    // patches for unknown objects are refused up front. Each patch is tagged
+    // with that scene's generation and held until the scene is live, so one
+    // sent between a publish and the swap isn't spent on the outgoing scene.
+    // Guarded by patch_mutex.
+    std::vector<std::pair<uint64_t, ItemPatch>> pending_patches;
+    std::unordered_set<std::string> scene_keys;
+    uint64_t scene_generation = 0; // Of the last published scene
+    std::mutex patch_mutex;
+    std::atomic<bool> patches_pending{false};
+    uint64_t live_generation = 0; // Of the scene on display; render thread only
+
+    // Shared-memory frame source; the watcher thread turns its doorbell into
+    // redraw requests while the scene shows it
+    std::shared_ptr<FrameRing> frame_ring;
+    std::thread frame_ring_thread;
+    std::atomic<bool> frame_ring_stop{false};
+    std::atomic<bool> external_active{false};
+
+    // Scenes published at scheduled times, independent of any client
+    std::unique_ptr<SceneScheduler> scheduler;
+
+    // Prepared scenes shown by ID
+    std::unique_ptr<SceneTemplates> templates;
+
+    // Scenes shown in rotation
+    std::unique_ptr<ScenePlaylist> playlist;
+
+    // Objects of the current scene: static ones first, then the animated
+    // ones from first_animated on, each group in scene order
+    std::vector<SceneItem> renderables;
+    size_t first_animated = 0;
+
+    // Frame rate used while the current renderables are animating
+    int target_fps = LedSignConstants::TARGET_FPS;
 
-    // Available fonts as file paths
-    std::vector<std::string> fonts;
+    // Font files found in the font directory, by name (file name without .bdf)
+    std::unordered_map<std::string, std::string> font_paths;
 
-    // Font cache - using unique_ptr to avoid copying Font objects
-    std::unordered_map<std::string, std::unique_ptr<rgb_matrix::Font>> font_cache;
+    // Precompiled atlases mapped from FONT_PACK_PATH; preferred over parsing .bdf files
+    FontPack font_pack;
 
-    rgb_matrix::Font current_font;
+    // Fonts are loaded on first use. Once the estimated size of the loaded
+    // fonts exceeds font_budget_bytes, the least recently used ones other than
+    // the default font are dropped again. Only the glyph atlas is kept, mapped
+    // from the pack or built once from the parsed .bdf file. Scenes share the
+    // atlases they draw with, so an evicted atlas lives on until the scenes
+    // using it are gone. Guarded by font_mutex, since scenes resolve their
+    // fonts on the thread that publishes them.
+    struct CachedFont {
+        std::shared_ptr<const GlyphAtlas> atlas;
+        size_t bytes = 0;
+        uint64_t last_used = 0;
+    };
+    std::unordered_map<std::string, CachedFont> font_cache;
+    size_t font_budget_bytes = LedSignConstants::FONT_CACHE_BUDGET_BYTES;
+    size_t font_cache_bytes = 0;
+    uint64_t font_use_clock = 0;
+    mutable std::mutex font_mutex;
 
-    std::shared_ptr<RGBMatrix> canvas;
+    // Sorted fonts the last published scene loaded, as written to SCENE_FONTS_PATH
+    std::vector<std::string> scene_fonts;
+    std::mutex scene_fonts_mutex;
+
+    // Font used when a text object names a font that can't be loaded. Shared
+    // with font_cache; the entry is never evicted while it is current.
+    std::shared_ptr<const GlyphAtlas> current_font;
+    std::string current_font_name;
+
+    // Displayed canvas - either the hardware matrix or an offscreen framebuffer
+    std::shared_ptr<rgb_matrix::Canvas> canvas;
+    CanvasBackend backend = CanvasBackend::HARDWARE;
+
+    // Backend-specific views of canvas (null when not in use)
+    RGBMatrix* matrix = nullptr;
+    std::shared_ptr<OffscreenCanvas> offscreen;
+
+    // Double buffering: frames are drawn into back_buffer and published by present()
+    rgb_matrix::Canvas* back_buffer = nullptr;
+    rgb_matrix::FrameCanvas* matrix_back_buffer = nullptr;
+    std::shared_ptr<OffscreenCanvas> offscreen_back_buffer;
+
+    // Compositor: static objects are cached in static_layer and frames are
+    // composed in memory in frame, where only the areas animated objects
+    // dirtied are restored and redrawn. Each back buffer remembers where it
+    // last received animated content so only changed areas are pushed to it.
+    struct BufferState {
+        bool valid = false;
+        std::vector<Rect> animated_rects;
+    };
+    std::unique_ptr<FrameBuffer> static_layer;
+    bool static_layer_valid = false;
+    std::unique_ptr<FrameBuffer> frame;
+    bool frame_valid = false;
+    std::vector<Rect> frame_rects;
+    std::unordered_map<const rgb_matrix::Canvas*, BufferState> buffer_states;
+
+    // Cross-fade into a scene published with fade_ms: the picture on display
+    // when it arrived is kept in fade_from and blended towards the new
+    // scene's frames in fade_frame until fade_duration has passed
+    std::unique_ptr<FrameBuffer> fade_from;
+    std::unique_ptr<FrameBuffer> fade_frame;
+    bool fading = false;
+    std::chrono::steady_clock::time_point fade_start;
+    std::chrono::milliseconds fade_duration{0};
     
     // Animation timing
     std::chrono::steady_clock::time_point last_render_time = std::chrono::steady_clock::now();
+    FrameScheduler frame_scheduler;
     
 
 public:
@@ -61,67 +185,201 @@ public:
     ~Sign();
 
     /**
-     * Initialize the LED matrix hardware and load fonts.
+     * Initialize the canvas backend, index the font directory and load the
+     * default font plus the fonts of the last scene.
+     * @param backend HARDWARE to drive the LED matrix, OFFSCREEN to render into memory
      * @return SignError::SUCCESS on success, or appropriate error code on failure
      */
-    SignError Initialize();
+    SignError Initialize(CanvasBackend backend = CanvasBackend::HARDWARE);
 
     /**
-     * Set the current font for text rendering.
+     * Set the current font for text rendering. The font is loaded once into
+     * the cache unless it is already there.
      * @param font_path Path to a .bdf font file
      */
     void setFont(const std::string &font_path);
 
     /**
-     * Get a font from the cache by name (e.g., "6x10").
+     * Get a font's glyph atlas by name, loading it on first use from the
+     * font pack or else from its .bdf file.
      * @param font_name Name of the font (without .bdf extension)
-     * @return Pointer to the font if found, nullptr otherwise
+     * @return The atlas if found, nullptr otherwise
      */
-    const rgb_matrix::Font* getFont(const std::string &font_name) const;
+    std::shared_ptr<const GlyphAtlas> getAtlas(const std::string &font_name);
 
     /**
-     * Load all available fonts into the cache.
-     * @return true if fonts were loaded successfully
+     * Get the font used for text whose font can't be loaded.
      */
-    bool loadAllFonts();
+    std::shared_ptr<const GlyphAtlas> currentFont() const;
 
     /**
-     * Clear the entire display.
+     * Index the .bdf files in the font directory without loading them.
+     * @return true if at least one font file was found
+     */
+    bool scanFonts();
+
+    /**
+     * Map a font pack built by the fontpack tool. Fonts loaded before
+     * keep their parsed atlases.
+     * @param path Pack file
+     * @return true if the pack was loaded
+     */
+    bool loadFontPack(const std::string &path);
+
+    /**
+     * Load the fonts named in SCENE_FONTS_PATH, written when a scene is published.
+     */
+    void prewarmFonts();
+
+    /**
+     * Clear the entire display. Once the render thread runs this publishes
+     * an empty scene instead of touching the buffers.
      */
     void clear();
 
+    /**
+     * Publish the back buffer. On hardware this swaps on the next vsync;
+     * the previously displayed buffer becomes the new back buffer.
+     */
+    void present();
+
     /**
      * Draw text at the specified position with given color and font.
+     * Only glyphs that intersect the display are drawn.
      * @param text Text string to render
-     * @param x X coordinate (pixels from left)
+     * @param x X coordinate (pixels from left, may be negative)
      * @param y Y coordinate (pixels from top) 
      * @param color RGB color for the text
-     * @param font Font to use for rendering
+     * @param atlas Glyph atlas of the font to use
      */
-    void drawText(const std::string &text, size_t x, size_t y, const rgb_matrix::Color &color, const rgb_matrix::Font &font) const;
+    void drawText(const std::string &text, int x, int y, const rgb_matrix::Color &color, const GlyphAtlas &atlas) const;
 
     /**
-     * Set display brightness.
+     * Draw the visible window of a pre-rasterized text strip.
+     * @param strip Rasterized text
+     * @param x X coordinate of the strip's left edge (may be negative)
+     * @param y Y coordinate of the text baseline
+     * @param color RGB color for the text
+     */
+    void drawStrip(const TextStrip &strip, int x, int y, const rgb_matrix::Color &color) const;
+
+    /**
+     * Draw an RGB image with its top-left corner at the display origin.
+     * Pixels outside the display are ignored.
+     * @param rgb Row-major RGB pixels, 3 bytes each
+     * @param width Image width in pixels
+     * @param height Image height in pixels
+     */
+    void drawImage(const uint8_t *rgb, int width, int height) const;
+
+    /**
+     * Set display brightness. Once the render thread runs the change is
+     * handed to it and applied at the next frame boundary.
      * @param brightness Brightness level (1-100)
      */
-    void setBrightness(int brightness) const;
+    void setBrightness(int brightness);
 
     /**
-     * Signal interruption to stop animation loops.
-     * @param interrupt true to interrupt, false to resume
+     * Start the render thread. It redraws continuously while the scene has
+     * animated objects and sleeps until the next scene otherwise.
      */
-    void handleInterrupt(bool interrupt);
+    void start();
 
     /**
-     * Start rendering all configured objects. Will run continuously if animated objects are present.
+     * Stop and join the render thread.
      */
-    void render();
+    void stop();
+
+    /**
+     * Ask the render thread to repaint the current scene, e.g. because an
+     * external source has new content. Does not block.
+     */
+    void requestRedraw();
+
+    /**
+     * Queue changes to a keyed object of the scene on display. Only that
+     * object is updated; the rest of the scene keeps running.
+     * @param patch Changes and the key of the object they apply to
+     * @return false if the last published scene has no object with that key
+     */
+    bool patchItem(ItemPatch patch);
+
+    /**
+     * Create the shared-memory frame ring and start watching its doorbell.
+     * @return true if the ring is available for SharedFrameObject scenes
+     */
+    bool openFrameRing();
+
+    /**
+     * Stop the doorbell watcher and remove the shared-memory frame ring.
+     */
+    void closeFrameRing();
+
+    /**
+     * Load the persisted schedule and start publishing scheduled scenes.
+     * @param path Schedule file, created on the first change if missing
+     */
+    void startScheduler(const std::string &path);
+
+    /**
+     * Stop publishing scheduled scenes. The schedule file is kept.
+     */
+    void stopScheduler();
+
+    /**
+     * Load the persisted scene templates and accept new ones.
+     * @param path Template file, created on the first change if missing
+     */
+    void loadTemplates(const std::string &path);
+
+    /**
+     * Load the persisted playlist and start the playlist thread, which
+     * resumes the rotation if it was running.
+     * @param path Playlist file, created on the first change if missing
+     */
+    void startPlaylist(const std::string &path);
+
+    /**
+     * Stop the playlist thread. The playlist file is kept.
+     */
+    void stopPlaylist();
+
+    /**
+     * Resolve the fonts and pre-rasterized text of a scene's objects.
+     * @param scene Scene to prepare; objects prepared before are skipped
+     */
+    void prepareScene(Scene &scene);
+
+    /**
+     * Prepare a scene and hand it to the render thread without blocking.
+     * If an earlier scene has not been picked up yet it is replaced. The
+     * scene takes over from the playlist, whose rotation is paused first.
+     * @param scene Scene to display from the next frame on
+     */
+    void publishScene(std::unique_ptr<Scene> scene);
+
+    /**
+     * Like publishScene(), for the playlist's own rotation; leaves it running.
+     * @param scene Scene to display from the next frame on
+     */
+    void publishPlaylistScene(std::unique_ptr<Scene> scene);
     
     /**
-     * Render a single frame of all objects.
+     * Render a single frame of all objects into the back buffer and present it.
      */
     void renderFrame();
     
+    /**
+     * Replace the current renderables and scene settings.
+     * @param scene Parsed scene to display
+     */
+    void setScene(Scene scene);
+
+    /**
+     * Drop cached frame content so the next frames are fully repainted.
+     */
+    void invalidateFrames();
+
     /**
      * Check if any of the current renderables require animation.
      * @return true if continuous rendering is needed
@@ -129,10 +387,30 @@ public:
     bool hasAnimatedObjects() const;
 
     /**
-     * Parse configuration string and render the specified objects.
+     * Parse configuration string and publish the specified objects.
      * @param config Configuration string defining objects to render
      */
-    void render(const std::string &config);
+    void render(std::string_view config);
 
+private:
+    void renderLoop();
+    void frameRingLoop();
+    bool takePendingScene();
+    bool applyPendingPatches();
+    void applyBrightness(int brightness);
+    SignError createHardwareCanvas();
+    SignError createOffscreenCanvas();
+    std::shared_ptr<const GlyphAtlas> loadAtlas(const std::string &font_name);
+    std::shared_ptr<const GlyphAtlas> cacheAtlas(const std::string &font_name, std::shared_ptr<const GlyphAtlas> atlas);
+    std::unique_ptr<rgb_matrix::Font> loadFontFile(const std::string &font_name);
+    void evictFonts(const std::string &keep);
+    void saveSceneFonts(const Scene &scene);
+    void handOffScene(std::unique_ptr<Scene> scene);
+    void rebuildStaticLayer();
+    void restoreStaticLayer(const Rect &rect);
+    void beginFade(std::chrono::milliseconds duration);
+    void pushFrame(const FrameBuffer &source, const Rect &rect, bool lit_only);
+    OffscreenCanvas *offscreenTarget() const;
+    FrameBuffer *frameTarget() const;
 };
 
@@ -1,66 +1,343 @@
 #pragma once
 #include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <fcntl.h>
 #include <cstring>
 #include <string>
 #include <iostream>
+#include <unordered_map>
 #include <vector>
 #include <csignal>
 #include <sys/stat.h>
-#include <thread>
 
+#include "binary_protocol.h"
 #include "constants.h"
 #include "sign.h"
 
 void cleanup_and_exit(int) {
     unlink(LedSignConstants::SOCKET_PATH);
+    shm_unlink(LedSignConstants::FRAME_RING_NAME);
     _exit(0);
 }
 
-bool write_all(int fd, const std::string& s) {
-    const char* p = s.c_str();
-    size_t n = s.size();
-    while (n) {
-        ssize_t k = ::write(fd, p, n);
-        if (k <= 0)
+/**
+ * State for one client connection. A connection can carry any number of
+ * newline-terminated text commands and framed binary messages, in any mix;
+ * replies are queued in the same order.
+ */
+struct ClientConnection {
+    int fd = -1;
+    std::string in;        // Received bytes not yet forming a full line or frame
+    std::string out;       // Replies not yet written
+    bool closing = false;  // Close once out is drained
+    bool want_write = false;
+};
+
+/**
+ * Execute one command line and return the reply (newline-terminated).
+ * Scene changes are handed to the render thread and never wait on it.
+ */
+std::string handle_command(Sign& sign, const std::string& line) {
+    if (line == "CLEAR") {
+        sign.publishScene(std::make_unique<Scene>());
+        return "OK cleared\n";
+    }
+
+    if (line == "SHM") {
+        // Show frames written to the shared-memory ring by a local producer
+        if (!sign.frame_ring)
+            return "ERR frame ring unavailable\n";
+        auto scene = std::make_unique<Scene>();
+        scene->renderables.emplace_back(std::in_place_type<SharedFrameObject>, sign.frame_ring);
+        sign.publishScene(std::move(scene));
+        return "OK shm\n";
+    }
+
+    if (line.compare(0, 9, "TEMPLATE ") == 0) {
+        // TEMPLATE <id> <config> | TEMPLATE DEL <id>
+        if (!sign.templates)
+            return "ERR templates unavailable\n";
+        std::string_view args = std::string_view(line).substr(9);
+        bool remove = args.compare(0, 4, "DEL ") == 0;
+        if (remove)
+            args.remove_prefix(4);
+
+        size_t space = remove ? args.size() : args.find(' ');
+        size_t id;
+        if (space == std::string_view::npos || !safeParseUInt(args.substr(0, space), id) || id > UINT32_MAX)
+            return "ERR invalid template id\n";
+        if (remove) {
+            if (!sign.templates->remove(static_cast<uint32_t>(id)))
+                return "ERR no such template\n";
+            return "OK template removed\n";
+        }
+        if (!sign.templates->store(sign, static_cast<uint32_t>(id), args.substr(space + 1)))
+            return "ERR invalid template\n";
+        return "OK template stored\n";
+    }
+
+    if (line.compare(0, 9, "ACTIVATE ") == 0) {
+        size_t id;
+        if (!safeParseUInt(std::string_view(line).substr(9), id) || id > UINT32_MAX)
+            return "ERR invalid template id\n";
+        if (!sign.templates || !sign.templates->activate(sign, static_cast<uint32_t>(id)))
+            return "ERR no such template\n";
+        return "OK activated\n";
+    }
+
+    if (line.compare(0, 9, "SCHEDULE ") == 0) {
+        // SCHEDULE ADD <entry> | SCHEDULE DEL <id> | SCHEDULE CLEAR, where an entry's
+        // scene may be "TEMPLATE <template_id>"
+        if (!sign.scheduler)
+            return "ERR scheduler unavailable\n";
+        std::string_view args = std::string_view(line).substr(9);
+
+        if (args.compare(0, 4, "ADD ") == 0) {
+            ScheduleEntry entry;
+            if (!parseScheduleEntry(args.substr(4), entry) || !sign.scheduler->add(entry))
+                return "ERR invalid schedule entry\n";
+            return "OK scheduled\n";
+        }
+        if (args.compare(0, 4, "DEL ") == 0) {
+            size_t id;
+            if (!safeParseUInt(args.substr(4), id) || id > UINT32_MAX)
+                return "ERR invalid schedule id\n";
+            if (!sign.scheduler->remove(static_cast<uint32_t>(id)))
+                return "ERR no such schedule entry\n";
+            return "OK unscheduled\n";
+        }
+        if (args == "CLEAR") {
+            sign.scheduler->clear();
+            return "OK schedule cleared\n";
+        }
+        return "ERR unknown schedule command\n";
+    }
+
+    if (line.compare(0, 9, "PLAYLIST ") == 0) {
+        // PLAYLIST ADD <duration_ms> <fade_ms> <config> | PLAYLIST START | PLAYLIST STOP | PLAYLIST CLEAR
+        if (!sign.playlist)
+            return "ERR playlist unavailable\n";
+        std::string_view args = std::string_view(line).substr(9);
+
+        if (args.compare(0, 4, "ADD ") == 0) {
+            args.remove_prefix(4);
+            size_t first = args.find(' ');
+            size_t second = first == std::string_view::npos ? first : args.find(' ', first + 1);
+            size_t duration_ms, fade_ms;
+            if (second == std::string_view::npos || !safeParseUInt(args.substr(0, first), duration_ms) ||
+                !safeParseUInt(args.substr(first + 1, second - first - 1), fade_ms) || duration_ms > UINT32_MAX || fade_ms > UINT32_MAX ||
+                !sign.playlist->add(static_cast<uint32_t>(duration_ms), static_cast<uint32_t>(fade_ms),
+                                    args.substr(second + 1)))
+                return "ERR invalid playlist entry\n";
+            return "OK playlist entry added\n";
+        }
+        if (args == "START") {
+            if (!sign.playlist->play())
+                return "ERR playlist empty\n";
+            return "OK playlist started\n";
+        }
+        if (args == "STOP") {
+            sign.playlist->pause();
+            return "OK playlist stopped\n";
+        }
+        if (args == "CLEAR") {
+            sign.playlist->clear();
+            return "OK playlist cleared\n";
+        }
+        return "ERR unknown playlist command\n";
+    }
+
+    if (line.compare(0, 6, "PATCH ") == 0) {
+        // PATCH <key>;<field>=<value>;... with fields text, color, x and y
+        ItemPatch patch;
+        if (!parseItemPatch(std::string_view(line).substr(6), patch))
+            return "ERR invalid patch\n";
+        if (!sign.patchItem(std::move(patch)))
+            return "ERR no such item\n";
+        return "OK patched\n";
+    }
+
+    if (line.compare(0, 3, "SET") == 0) {
+        sign.render(std::string_view(line).substr(3));
+        return "OK setting\n";
+    }
+
+    return "ERR unknown command\n";
+}
+
+/**
+ * Execute one binary message and return the encoded reply.
+ * @param header Decoded message header
+ * @param payload Exactly header.length bytes
+ * @return The reply, or an empty string if the header asked for none
+ */
+std::string handle_binary_message(Sign& sign, const BinaryHeader& header, std::string_view payload) {
+    std::string reply;
+
+    if (header.version != LedSignConstants::BINARY_PROTOCOL_VERSION) {
+        reply = encodeBinaryReply(BinaryStatus::UNSUPPORTED_VERSION, "unsupported protocol version");
+    } else {
+        switch (header.opcode) {
+        case BinaryOpcode::CLEAR:
+            sign.publishScene(std::make_unique<Scene>());
+            reply = encodeBinaryReply(BinaryStatus::OK, "cleared");
+            break;
+
+        case BinaryOpcode::SET_SCENE: {
+            auto scene = std::make_unique<Scene>();
+            if (!decodeScenePayload(payload, *scene)) {
+                reply = encodeBinaryReply(BinaryStatus::BAD_REQUEST, "invalid scene");
+                break;
+            }
+            sign.publishScene(std::move(scene));
+            reply = encodeBinaryReply(BinaryStatus::OK, "setting");
+            break;
+        }
+
+        case BinaryOpcode::FRAME_RAW:
+        case BinaryOpcode::FRAME_RLE: {
+            std::vector<uint8_t> rgb;
+            if (!decodeFramePayload(header.opcode, payload, sign.width, sign.height, rgb)) {
+                reply = encodeBinaryReply(BinaryStatus::BAD_REQUEST, "invalid frame");
+                break;
+            }
+            auto scene = std::make_unique<Scene>();
+            scene->renderables.emplace_back(std::in_place_type<ImageObject>, sign.width, sign.height, std::move(rgb));
+            sign.publishScene(std::move(scene));
+            reply = encodeBinaryReply(BinaryStatus::OK, "frame");
+            break;
+        }
+
+        default:
+            reply = encodeBinaryReply(BinaryStatus::UNKNOWN_OPCODE, "unknown opcode");
+            break;
+        }
+    }
+
+    // Streaming producers don't read acks; errors are still logged above
+    if (header.flags & BINARY_FLAG_NO_REPLY)
+        return {};
+    return reply;
+}
+
+/**
+ * Run every complete message at the front of the input buffer.
+ * @return false if the connection must be closed after the queued replies
+ */
+bool process_input(Sign& sign, ClientConnection& client) {
+    size_t start = 0;
+    bool keep_open = true;
+
+    while (start < client.in.size()) {
+        std::string_view pending = std::string_view(client.in).substr(start);
+
+        if (static_cast<unsigned char>(pending[0]) == LedSignConstants::BINARY_MAGIC) {
+            BinaryHeader header;
+            if (!decodeBinaryHeader(pending, header))
+                break; // header not complete yet
+
+            if (header.length > LedSignConstants::MAX_MESSAGE_SIZE) {
+                client.out += encodeBinaryReply(BinaryStatus::BAD_REQUEST, "message too long");
+                keep_open = false; // sanity cap; the stream can't be resynchronized
+                start = client.in.size();
+                break;
+            }
+
+            size_t frame_size = LedSignConstants::BINARY_HEADER_SIZE + header.length;
+            if (pending.size() < frame_size) {
+                // Size the buffer once so the rest of the frame lands without regrowth
+                client.in.reserve(start + frame_size);
+                break;
+            }
+
+            client.out += handle_binary_message(sign, header,
+                                                pending.substr(LedSignConstants::BINARY_HEADER_SIZE, header.length));
+            start += frame_size;
+            continue;
+        }
+
+        size_t newline = pending.find('\n');
+        if (newline == std::string_view::npos)
+            break; // line not complete yet
+
+        client.out += handle_command(sign, std::string(pending.substr(0, newline)));
+        start += newline + 1;
+    }
+    client.in.erase(0, start);
+
+    // A pending binary frame is already bounded by its header check
+    bool pending_text = !client.in.empty() &&
+                        static_cast<unsigned char>(client.in[0]) != LedSignConstants::BINARY_MAGIC;
+    if (keep_open && pending_text && client.in.size() > LedSignConstants::MAX_MESSAGE_SIZE) {
+        client.out += "ERR message too long\n";
+        client.in.clear();
+        keep_open = false; // sanity cap
+    }
+    return keep_open;
+}
+
+/**
+ * Write as much of the pending output as the socket accepts without blocking.
+ * @return false if the connection failed
+ */
+bool flush_client(ClientConnection& client) {
+    while (!client.out.empty()) {
+        ssize_t k = ::send(client.fd, client.out.data(), client.out.size(), MSG_NOSIGNAL);
+        if (k < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
             return false;
-        p += k;
-        n -= (size_t)k;
+        }
+        client.out.erase(0, (size_t)k);
     }
     return true;
 }
 
-bool read_line(int fd, std::string& out) {
-    out.clear();
-    char buf[256];
+/**
+ * Read everything available and run each complete command or frame.
+ * @return false if the peer closed the connection or it failed
+ */
+bool read_client(Sign& sign, ClientConnection& client) {
+    char buf[4096];
     while (true) {
-        ssize_t k = ::read(fd, buf, sizeof(buf));
-        if (k == 0)
-            return !out.empty(); // EOF
+        ssize_t k = ::read(client.fd, buf, sizeof(buf));
+        if (k == 0) {
+            // EOF: a final text command without a trailing newline still counts
+            if (!client.in.empty() &&
+                static_cast<unsigned char>(client.in[0]) != LedSignConstants::BINARY_MAGIC) {
+                client.out += handle_command(sign, client.in);
+            }
+            client.in.clear();
+            return false;
+        }
         if (k < 0) {
             if (errno == EINTR)
                 continue;
-            return false;
-        }
-        for (ssize_t i = 0; i < k; ++i) {
-            char c = buf[i];
-            if (c == '\n')
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
                 return true;
-            out.push_back(c);
-            if (out.size() > LedSignConstants::MAX_MESSAGE_SIZE)
-                return false; // sanity cap
+            return false;
         }
+
+        client.in.append(buf, (size_t)k);
+
+        if (!process_input(sign, client))
+            return false;
     }
 }
 
+void close_client(int epfd, std::unordered_map<int, ClientConnection>& clients, int fd) {
+    ::epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    clients.erase(fd);
+}
 
-int run_socket_server(Sign& sign) {
-
-    // Create the sign worker thread
-    std::thread t;
 
+int run_socket_server(Sign& sign) {
 
     // Clean up socket file on crash/ctrl-c
     struct sigaction sa{};
@@ -71,7 +348,7 @@ int run_socket_server(Sign& sign) {
 
     // Create, bind, listen
     ::unlink(LedSignConstants::SOCKET_PATH);
-    int s = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    int s = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (s < 0) {
         perror("socket");
         return 1;
@@ -97,62 +374,107 @@ int run_socket_server(Sign& sign) {
         return 1;
     }
 
+    int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        perror("epoll_create1");
+        return 1;
+    }
+
+    epoll_event listen_ev{};
+    listen_ev.events = EPOLLIN;
+    listen_ev.data.fd = s;
+    if (::epoll_ctl(epfd, EPOLL_CTL_ADD, s, &listen_ev) < 0) {
+        perror("epoll_ctl");
+        return 1;
+    }
+
     std::cout << "LED sign daemon listening on " << LedSignConstants::SOCKET_PATH << std::endl;
 
+    std::unordered_map<int, ClientConnection> clients;
+    epoll_event events[LedSignConstants::EPOLL_MAX_EVENTS];
+    bool running = true;
 
-    while (true) {
-        int c = ::accept(s, nullptr, nullptr);
-        if (c < 0) {
+    while (running) {
+        int n = ::epoll_wait(epfd, events, LedSignConstants::EPOLL_MAX_EVENTS, -1);
+        if (n < 0) {
             if (errno == EINTR)
                 continue;
-            perror("accept");
+            perror("epoll_wait");
             break;
         }
 
-        std::string line;
-        if (!read_line(c, line)) {
-            write_all(c, "ERR read failed\n");
-            ::close(c);
-            continue;
-        }
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
 
-        std::string reply;
+            if (fd == s) {
+                // Accept every pending connection
+                while (true) {
+                    int c = ::accept4(s, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (c < 0) {
+                        if (errno == EINTR)
+                            continue;
+                        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                            perror("accept");
+                            running = false;
+                        }
+                        break;
+                    }
+                    if (clients.size() >= LedSignConstants::MAX_CLIENTS) {
+                        ::send(c, "ERR too many connections\n", 25, MSG_NOSIGNAL);
+                        ::close(c);
+                        continue;
+                    }
 
-        if (line == "CLEAR") {
-            sign.handleInterrupt(true);
-            if (t.joinable())
-                t.join();
-            sign.clear();
-            reply = "OK cleared\n";
-        }
+                    epoll_event ev{};
+                    ev.events = EPOLLIN | EPOLLRDHUP;
+                    ev.data.fd = c;
+                    if (::epoll_ctl(epfd, EPOLL_CTL_ADD, c, &ev) < 0) {
+                        perror("epoll_ctl");
+                        ::close(c);
+                        continue;
+                    }
+                    clients[c].fd = c;
+                }
+                continue;
+            }
 
-        else if (line.substr(0, 3) == "SET") {
-            std::string msg = line.substr(3);
-            sign.handleInterrupt(true);
-            if (t.joinable())
-                t.join();
-            sign.handleInterrupt(false);
-            t = std::thread([&sign, msg]() {
-                sign.render(msg);
-            });
-            reply = "OK setting\n";
-        }
+            auto it = clients.find(fd);
+            if (it == clients.end())
+                continue;
+            ClientConnection& client = it->second;
 
-        else {
-            reply = "ERR unknown command\n";
-        }
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                if (!client.closing && !read_client(sign, client))
+                    client.closing = true;
+            }
 
-        write_all(c, reply);
-        ::close(c);
-    }
+            if (!flush_client(client)) {
+                close_client(epfd, clients, fd);
+                continue;
+            }
+
+            if (client.out.empty() && client.closing) {
+                close_client(epfd, clients, fd);
+                continue;
+            }
 
-    // Ensure thread is properly joined before cleanup
-    if (t.joinable()) {
-        sign.handleInterrupt(true);
-        t.join();
+            // Only wait for writability while replies are backed up
+            bool want_write = !client.out.empty();
+            if (want_write != client.want_write) {
+                epoll_event ev{};
+                ev.events = want_write ? EPOLLOUT : (EPOLLIN | EPOLLRDHUP);
+                ev.data.fd = fd;
+                ::epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev);
+                client.want_write = want_write;
+            }
+        }
     }
 
+    for (auto& entry : clients)
+        ::close(entry.first);
+    ::close(epfd);
+    ::close(s);
+
     ::unlink(LedSignConstants::SOCKET_PATH);
     return 0;
 }
-
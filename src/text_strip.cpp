@@ -0,0 +1,95 @@
+#include "text_strip.h"
+#include "utf8.h"
+#include <algorithm>
+
+TextStrip TextStrip::Rasterize(const std::string &text, const GlyphAtlas &atlas) {
+    TextStrip strip;
+    strip.height = atlas.height();
+    strip.baseline = atlas.baseline();
+
+    // Measure first so the bitmap is allocated once
+    const char *end = text.data() + text.size();
+    int total = 0;
+    for (const char *it = text.data(); it < end;) {
+        total += atlas.advance(utf8NextCodepoint(it, end));
+    }
+    strip.width = total;
+    strip.stride = (static_cast<size_t>(strip.width) + 7) / 8;
+    strip.bits.assign(strip.stride * strip.height, 0);
+    if (strip.width == 0) {
+        return strip;
+    }
+
+    // OR each glyph's rows into the strip a byte at a time
+    const size_t glyph_stride = atlas.stride();
+    int pen = 0;
+    for (const char *it = text.data(); it < end;) {
+        int glyph = atlas.glyphIndex(utf8NextCodepoint(it, end));
+        if (glyph == GlyphAtlas::NO_GLYPH) {
+            continue;
+        }
+        const unsigned shift = pen & 7;
+        const size_t first = static_cast<size_t>(pen) >> 3;
+        const uint8_t *src = atlas.glyphBits(glyph);
+        for (int row = 0; row < strip.height; ++row, src += glyph_stride) {
+            uint8_t *dst = &strip.bits[row * strip.stride];
+            for (size_t i = 0; i < glyph_stride && first + i < strip.stride; ++i) {
+                uint8_t byte = src[i];
+                if (byte == 0) {
+                    continue;
+                }
+                dst[first + i] |= static_cast<uint8_t>(byte >> shift);
+                if (shift && first + i + 1 < strip.stride) {
+                    dst[first + i + 1] |= static_cast<uint8_t>(byte << (8 - shift));
+                }
+            }
+        }
+        pen += atlas.glyphAdvance(glyph);
+    }
+
+    // Drop anything the last glyph drew past the end of the text
+    const unsigned tail = strip.width & 7;
+    if (tail) {
+        const uint8_t keep = static_cast<uint8_t>(0xFF << (8 - tail));
+        for (int row = 0; row < strip.height; ++row) {
+            strip.bits[row * strip.stride + strip.stride - 1] &= keep;
+        }
+    }
+    return strip;
+}
+
+bool TextStrip::pixel(int x, int y) const {
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        return false;
+    }
+    return bits[y * stride + (x >> 3)] & (0x80 >> (x & 7));
+}
+
+void TextStrip::Blit(rgb_matrix::Canvas *canvas, int x, int y, const rgb_matrix::Color &color) const {
+    // Only walk the columns and rows that land on the canvas
+    const int top = y - baseline;
+    const int col_begin = std::max(0, -x);
+    const int col_end = std::min(width, canvas->width() - x);
+    const int row_begin = std::max(0, -top);
+    const int row_end = std::min(height, canvas->height() - top);
+
+    for (int row = row_begin; row < row_end; ++row) {
+        const uint8_t *line = &bits[row * stride];
+        int col = col_begin;
+        while (col < col_end) {
+            uint8_t byte = line[col >> 3];
+            if (byte == 0) {
+                col = (col | 7) + 1; // Skip the rest of an empty byte
+                continue;
+            }
+            if (byte & (0x80 >> (col & 7))) {
+                canvas->SetPixel(x + col, top + row, color.r, color.g, color.b);
+            }
+            ++col;
+        }
+    }
+}
+
+void TextStrip::Blit(FrameBuffer &target, int x, int y, const rgb_matrix::Color &color) const {
+    target.DrawBits(bits.data(), stride, 0, x, y - baseline, width, height, color);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "canvas.h"
+#include "frame_buffer.h"
+#include "glyph_atlas.h"
+#include "graphics.h"
+
+/**
+ * A line of text rasterized once into a 1-bit bitmap.
+ *
+ * Rows are packed MSB-first, `stride` bytes per row. Row `baseline` is the
+ * text baseline, matching the y coordinate convention of rgb_matrix::DrawText.
+ */
+struct TextStrip {
+public:
+    int width = 0;     // Total advance width of the text in pixels
+    int height = 0;    // Font height in pixels
+    int baseline = 0;  // Baseline row within the strip
+    size_t stride = 0; // Bytes per row
+    std::vector<uint8_t> bits;
+
+    /**
+     * Rasterize text from a font's glyph atlas.
+     * @param text UTF-8 text
+     * @param atlas Glyph atlas of the font to render with
+     * @return Strip covering the whole text
+     */
+    static TextStrip Rasterize(const std::string &text, const GlyphAtlas &atlas);
+
+    /**
+     * Check whether a strip pixel is set.
+     */
+    bool pixel(int x, int y) const;
+
+    /**
+     * Draw the part of the strip that falls inside the canvas.
+     * @param canvas Target canvas
+     * @param x Canvas x of the strip's left edge (may be negative)
+     * @param y Canvas y of the strip's baseline
+     * @param color Foreground color
+     */
+    void Blit(rgb_matrix::Canvas *canvas, int x, int y, const rgb_matrix::Color &color) const;
+
+    /**
+     * Draw the visible part of the strip into a framebuffer, a row of bits at a time.
+     */
+    void Blit(FrameBuffer &target, int x, int y, const rgb_matrix::Color &color) const;
+};
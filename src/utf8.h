@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Decode the next UTF-8 codepoint and advance the iterator past it.
+ * Malformed or truncated sequences decode byte by byte so that decoding
+ * always makes progress.
+ * @param it Current position, advanced past the decoded sequence
+ * @param end One past the last byte of the text
+ * @return The decoded codepoint
+ */
+inline uint32_t utf8NextCodepoint(const char *&it, const char *end) {
+    const uint8_t lead = static_cast<uint8_t>(*it++);
+    if (lead < 0x80) {
+        return lead;
+    }
+
+    int continuation;
+    uint32_t cp;
+    if ((lead & 0xE0) == 0xC0) {
+        continuation = 1;
+        cp = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        continuation = 2;
+        cp = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+        continuation = 3;
+        cp = lead & 0x07;
+    } else {
+        return lead;
+    }
+
+    const char *p = it;
+    for (int i = 0; i < continuation; ++i, ++p) {
+        if (p >= end || (static_cast<uint8_t>(*p) & 0xC0) != 0x80) {
+            return lead;
+        }
+        cp = (cp << 6) | (static_cast<uint8_t>(*p) & 0x3F);
+    }
+    it = p;
+    return cp;
+}
@@ -4,13 +4,12 @@ from datetime import datetime
 from pathlib import Path
 
 from flask import Flask, render_template, request, redirect, url_for, flash
-from apscheduler.schedulers.background import BackgroundScheduler
-from apscheduler.triggers.date import DateTrigger
-from apscheduler.triggers.cron import CronTrigger
 
 # Local imports
 import sign
-from sign import clear_sign, execute_scheduled_item
+from sign import clear_sign, schedule_item, unschedule_item, sync_schedule
+from sign import upload_template, remove_uploaded_template, sync_templates
+from sign import play_playlist, stop_playlist
 from sql import *
 from form import *
 
@@ -25,80 +24,24 @@ app.config.update(
     SESSION_COOKIE_SAMESITE='Lax'
 )
 
-# Initialize scheduler
-scheduler = BackgroundScheduler(
-    job_defaults=dict(coalesce=True, max_instances=1, misfire_grace_time=10)
-)
-
-
 # Scheduler Integration Functions
 def load_scheduled_jobs():
     """
-    Load all scheduled jobs from the database and add them to the scheduler.
-    This function is called during application startup.
+    Hand all scheduled items in the database to the sign daemon, which fires
+    them itself from then on. This function is called during application startup.
     """
-
     now = datetime.now()
     clear_expired_scheduled_items(now)
 
-    scheduled_items = get_all_scheduled_items()
-    
-    for item in scheduled_items:
-        try:
-            # Parse the scheduled datetime
-            scheduled_dt = datetime.fromisoformat(item['scheduled_datetime'])
-            
-            # Skip past items unless they're recurring
-            if not item['is_recurring'] and scheduled_dt < datetime.now():
-                continue
-            
-            # Get template payload if template_id is specified
-            payload_data = None
-            if item['template_id']:
-                template = get_template(item['template_id'])
-                if template:
-                    payload_data = parseJSONPayload(template['payload'])
-            
-            # Create job kwargs
-            job_kwargs = {
-                'schedule_id': item['id'],
-                'name': item['name']
-            }
-            
-            # Determine trigger type
-            if item['is_recurring'] == 1:
-                # For recurring items, use weekday/time if available
-                if item['recurring_weekdays'] and item['recurring_time']:
-                    cron_expr = create_cron_from_weekdays_time(item['recurring_weekdays'], item['recurring_time'])
-                    if cron_expr:
-                        trigger = CronTrigger.from_crontab(cron_expr)
-                    else:
-                        trigger = CronTrigger.from_crontab('0 * * * *')  # Fallback: every hour
-                else:
-                    trigger = CronTrigger.from_crontab('0 * * * *')  # Default: every hour
-            else:
-                # One-time scheduled item
-                trigger = DateTrigger(run_date=scheduled_dt)
-
-            
-            # Add job to scheduler
-            scheduler.add_job(
-                func=execute_scheduled_item,
-                trigger=trigger,
-                id=f"schedule_{item['id']}",
-                kwargs=job_kwargs,
-                replace_existing=True
-            )
-            
-            print(f"Loaded scheduled job: {item['name']} at {item['scheduled_datetime']}")
-            
-        except Exception as e:
-            print(f"Error loading scheduled job {item['id']}: {e}")
+    response = sync_templates()
+    if response.startswith("ERR"):
+        print(f"Could not upload templates to the LED sign: {response}")
 
+    response = sync_schedule()
+    if response.startswith("ERR"):
+        print(f"Could not sync schedule with the LED sign: {response}")
 
 
-
-# Flask Routes
 @app.route('/')
 def index():
     """Main dashboard page"""
@@ -123,6 +66,7 @@ def route_purge_schedule():
     """Purge all scheduled items"""
     try:
         purge_scheduled_items()
+        sign.send_command("SCHEDULE CLEAR")
         flash('All scheduled items purged successfully', 'success')
     except Exception as e:
         flash(f'Error purging scheduled items: {str(e)}', 'error')
@@ -184,8 +128,9 @@ def route_manual_control():
 
 @app.route('/clear_sign', methods=['POST'])
 def route_clear_sign():
-    """Clear the sign display"""
+    """Clear the sign display and stop the playlist so it doesn't bring a scene back"""
     try:
+        stop_playlist()
         clear_sign()
         flash('Sign cleared successfully', 'success')
     except Exception as e:
@@ -194,6 +139,36 @@ def route_clear_sign():
     return redirect(url_for('index'))
 
 
+@app.route('/start_playlist', methods=['POST'])
+def route_start_playlist():
+    """Rotate through templates on the sign; the daemon keeps it running across restarts"""
+    try:
+        entries = parsePlaylistForm(request.form)
+        response = play_playlist(entries)
+        if response.startswith("ERR"):
+            flash(f'Could not start playlist: {response}', 'error')
+        else:
+            flash(f'Playlist of {len(entries)} templates started', 'success')
+    except ValueError as e:
+        flash(str(e), 'error')
+    except Exception as e:
+        flash(f'Error starting playlist: {str(e)}', 'error')
+
+    return redirect(url_for('index'))
+
+
+@app.route('/stop_playlist', methods=['POST'])
+def route_stop_playlist():
+    """Stop rotating templates; the current scene stays up"""
+    try:
+        stop_playlist()
+        flash('Playlist stopped', 'success')
+    except Exception as e:
+        flash(f'Error stopping playlist: {str(e)}', 'error')
+
+    return redirect(url_for('index'))
+
+
 @app.route('/add_schedule', methods=['POST'])
 def route_add_schedule():
     """Add a new scheduled item"""
@@ -225,6 +200,7 @@ def route_add_schedule():
             }]
         })
         form['template_id'] = add_template(f"Custom_{form['schedule_name']}", payload)
+        upload_template(form['template_id'])
     
 
     
@@ -236,33 +212,11 @@ def route_add_schedule():
         recurring_weekdays=form['recurring_weekdays'],
     )
 
-    # Add to scheduler if it's a future time or recurring
-    if form['is_recurring'] and form['recurring_weekdays'] and form['scheduled_datetime']:
-        # Use weekday-based scheduling
-        cron_expr = create_cron_from_weekdays_time(form['recurring_weekdays'], form['scheduled_datetime'])
-        if cron_expr:
-            trigger = CronTrigger.from_crontab(cron_expr)
-        else:
-            trigger = CronTrigger.from_crontab('0 9 * * *')  # Fallback: 9 AM daily
-            
-        scheduler.add_job(
-            func=execute_scheduled_item,
-            trigger=trigger,
-            id=f"schedule_{item_id}",
-            kwargs={'schedule_id': item_id, 'name': form['schedule_name']},
-            replace_existing=True
-        )
-    elif not form['is_recurring']:
-        # One-time scheduled item
-        scheduled_dt = datetime.fromisoformat(form['scheduled_datetime'])
-        if scheduled_dt > datetime.now():
-            scheduler.add_job(
-                func=execute_scheduled_item,
-                trigger=DateTrigger(run_date=scheduled_dt),
-                id=f"schedule_{item_id}",
-                kwargs={'schedule_id': item_id, 'name': form['schedule_name']},
-                replace_existing=True
-            )
+    # The daemon fires the item from now on, even while this app is down
+    response = schedule_item(item_id)
+    if response.startswith("ERR"):
+        flash(f'Scheduled item saved but not sent to the sign: {response}', 'error')
+        return redirect(url_for('index'))
 
     flash(f'Scheduled item "{form["schedule_name"]}" added successfully', 'success')
     
@@ -273,11 +227,8 @@ def route_add_schedule():
 def route_delete_schedule(item_id):
     """Delete a scheduled item"""
     try:
-        # Remove from scheduler
-        try:
-            scheduler.remove_job(f"schedule_{item_id}")
-        except:
-            pass  # Job might not exist in scheduler
+        # Remove from the daemon's scheduler (it may have fired already)
+        unschedule_item(item_id)
         
         # Remove from database
         success = remove_scheduled_item(item_id)
@@ -310,6 +261,7 @@ def route_add_template():
             
         payload = json.dumps(form_json)
         template_id = add_template(name=label, payload=payload)
+        upload_template(template_id)
         flash(f'Template "{label}" created successfully', 'success')
 
     except json.JSONDecodeError:
@@ -324,8 +276,14 @@ def route_add_template():
 def route_delete_template(template_id):
     """Delete a template"""
     try:
+        # Deleting the template deletes its schedule rows too, so take them
+        # off the sign's schedule as well
+        for item in get_scheduled_items_by_template(template_id):
+            unschedule_item(item['id'])
+
         success = remove_template(template_id)
         if success:
+            remove_uploaded_template(template_id)
             flash('Template deleted successfully', 'success')
         else:
             flash('Template not found', 'error')
@@ -344,12 +302,10 @@ if __name__ == "__main__":
     
     print("Initializing database...")
     init_db()
-    recover_scheduled_jobs()
 
-    # Load existing scheduled jobs from database and start scheduler
+    # Send existing scheduled items to the sign daemon's scheduler
     print("Loading scheduled jobs...")
     load_scheduled_jobs()
-    scheduler.start()
     
     # Run Flask app with configurable settings
     host = os.environ.get('FLASK_HOST', '0.0.0.0')
@@ -64,6 +64,20 @@ def parseScheduleForm(form):
     }
 
 
+def parsePlaylistForm(form):
+    """Parse and validate playlist form data"""
+    template_ids = [int(template_id) for template_id in form.getlist('template_ids') if template_id]
+    if not template_ids:
+        raise ValueError("Please select at least one template")
+
+    seconds = float(form.get('seconds', 10))
+    fade_seconds = float(form.get('fade_seconds', 0))
+    if seconds <= 0 or fade_seconds < 0 or fade_seconds > seconds:
+        raise ValueError("Each scene must show for longer than its fade")
+
+    return [(template_id, seconds, fade_seconds) for template_id in template_ids]
+
+
 def parse_form(form):
     """Parse form data into JSON payload"""
     template_type = "static"
@@ -13,42 +13,189 @@ C++ LED sign control system.
 """
 
 import socket
+import struct
+import threading
+from datetime import datetime
 from sql import *
 
-def send_command(command):
-    """Send a command to the LED sign server and return the response."""
-    SOCK_PATH = "/tmp/ledsign.sock"
+SOCK_PATH = "/tmp/ledsign.sock"
+
+# Binary protocol framing (see src/binary_protocol.h)
+BINARY_HEADER = struct.Struct('<BBBBI')
+BINARY_MAGIC = 0xB5
+BINARY_VERSION = 1
+OP_CLEAR = 0x01
+OP_SET_SCENE = 0x02
+OP_FRAME_RAW = 0x03
+OP_FRAME_RLE = 0x04
+OP_REPLY = 0x80
+FLAG_NO_REPLY = 0x01
+ITEM_STATIC = 0x01
+ITEM_SCROLL = 0x02
+ITEM_FPS = 0x03
+ITEM_KEY = 0x04
+SCROLL_FLAG_DITHER = 0x01
+
+# One long-lived connection shared by all callers; the daemon accepts any
+# number of newline-terminated commands per connection and replies in order.
+_connection = None
+_connection_reader = None
+_connection_lock = threading.Lock()
+
+
+def _close_connection():
+    """Drop the shared connection so the next command reconnects."""
+    global _connection, _connection_reader
     try:
-        # Create Unix domain socket
+        if _connection_reader is not None:
+            _connection_reader.close()
+        if _connection is not None:
+            _connection.close()
+    except OSError:
+        pass
+    _connection = None
+    _connection_reader = None
+
+
+def _get_connection():
+    """Return the shared connection, connecting if needed."""
+    global _connection, _connection_reader
+    if _connection is None:
         sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
-        
-        # Connect to server
-        sock.connect(SOCK_PATH)
-        
-        # Send command with newline
-        command_line = command + "\n"
-        sock.sendall(command_line.encode('utf-8'))
-        
-        # Read response until newline
-        response = ""
-        while True:
-            data = sock.recv(1)
-            if not data:
-                break
-            char = data.decode('utf-8')
-            if char == '\n':
-                break
-            response += char
-        
-        sock.close()
-        return response
-        
-    except FileNotFoundError:
-        return "ERROR: LED sign server not running (socket not found)"
-    except ConnectionRefusedError:
-        return "ERROR: Connection refused by LED sign server"
-    except Exception as e:
-        return f"ERROR: {str(e)}"
+        try:
+            sock.connect(SOCK_PATH)
+        except OSError:
+            sock.close()
+            raise
+        _connection = sock
+        _connection_reader = sock.makefile('rb')
+    return _connection, _connection_reader
+
+
+def _read_text_reply(reader):
+    """Read a newline-terminated text reply."""
+    response = reader.readline()
+    if not response:
+        raise ConnectionResetError("connection closed by LED sign server")
+    return response.decode('utf-8').rstrip('\n')
+
+
+def _read_binary_reply(reader):
+    """Read a framed binary reply and render it like a text reply."""
+    header = reader.read(BINARY_HEADER.size)
+    if len(header) < BINARY_HEADER.size:
+        raise ConnectionResetError("connection closed by LED sign server")
+    magic, _version, opcode, _flags, length = BINARY_HEADER.unpack(header)
+    payload = reader.read(length)
+    if magic != BINARY_MAGIC or opcode != OP_REPLY or len(payload) < 1 or len(payload) != length:
+        raise ConnectionResetError("malformed reply from LED sign server")
+    status = "OK" if payload[0] == 0 else "ERR"
+    return f"{status} {payload[1:].decode('utf-8', 'replace')}"
+
+
+def _transact(data, read_reply):
+    """Send one message on the shared connection and return its reply."""
+    with _connection_lock:
+        # Retry once on a fresh connection if the daemon restarted under us
+        for attempt in range(2):
+            try:
+                sock, reader = _get_connection()
+                sock.sendall(data)
+                return read_reply(reader)
+
+            except FileNotFoundError:
+                _close_connection()
+                return "ERROR: LED sign server not running (socket not found)"
+            except ConnectionRefusedError:
+                _close_connection()
+                return "ERROR: Connection refused by LED sign server"
+            except (BrokenPipeError, ConnectionResetError) as e:
+                _close_connection()
+                if attempt == 1:
+                    return f"ERROR: {str(e)}"
+            except Exception as e:
+                _close_connection()
+                return f"ERROR: {str(e)}"
+
+
+def send_command(command):
+    """Send a command to the LED sign server and return the response."""
+    return _transact((command + "\n").encode('utf-8'), _read_text_reply)
+
+
+def _encode_string(value, length_format):
+    data = str(value).encode('utf-8')
+    return struct.pack(length_format, len(data)) + data
+
+
+def _encode_key(key):
+    """Encode the KEY item that names the item before it for PATCH, if there is a key."""
+    return struct.pack('<B', ITEM_KEY) + _encode_string(key, '<B') if key else b""
+
+
+def encode_static_item(text, x, y, color, font="6x10", key=None):
+    """Encode a STATIC item for a binary SET_SCENE payload, with an optional key for PATCH."""
+    r, g, b = color
+    return (struct.pack('<BHHBBB', ITEM_STATIC, int(x), int(y), r, g, b)
+            + _encode_string(font, '<B') + _encode_string(text, '<H') + _encode_key(key))
+
+
+def encode_scroll_item(text, y, color, speed, font="6x10", dither=False, key=None):
+    """Encode a SCROLL item for a binary SET_SCENE payload, with an optional key for PATCH."""
+    r, g, b = color
+    flags = SCROLL_FLAG_DITHER if dither else 0
+    return (struct.pack('<BHBBBHB', ITEM_SCROLL, int(y), r, g, b, int(speed), flags)
+            + _encode_string(font, '<B') + _encode_string(text, '<H') + _encode_key(key))
+
+
+def encode_fps_item(fps):
+    """Encode an FPS item for a binary SET_SCENE payload."""
+    return struct.pack('<BH', ITEM_FPS, int(fps))
+
+
+def send_binary(opcode, payload=b"", flags=0):
+    """Send a framed binary message and return the response (None if no reply was requested)."""
+    header = BINARY_HEADER.pack(BINARY_MAGIC, BINARY_VERSION, opcode, flags, len(payload))
+    read_reply = (lambda reader: None) if flags & FLAG_NO_REPLY else _read_binary_reply
+    return _transact(header + payload, read_reply)
+
+
+def send_scene(items):
+    """Replace the displayed scene with encoded items using the binary protocol."""
+    return send_binary(OP_SET_SCENE, b"".join(items))
+
+
+def encode_frame_rle(pixels):
+    """Run-length encode RGB bytes as (count-1, r, g, b) runs of up to 256 pixels."""
+    out = bytearray()
+    i = 0
+    end = len(pixels)
+    while i < end:
+        color = pixels[i:i + 3]
+        run = 1
+        while run < 256 and i + run * 3 < end and pixels[i + run * 3:i + run * 3 + 3] == color:
+            run += 1
+        out.append(run - 1)
+        out += color
+        i += run * 3
+    return bytes(out)
+
+
+def send_frame(pixels, width=64, height=32, rle=True, stream=False):
+    """
+    Display a full RGB frame (row-major, 3 bytes per pixel) on the next vsync.
+    With stream=True no reply is requested, so consecutive frames can be pushed
+    without waiting for the daemon.
+    """
+    pixels = bytes(pixels)
+    payload = struct.pack('<HH', width, height)
+    if rle:
+        opcode = OP_FRAME_RLE
+        payload += encode_frame_rle(pixels)
+    else:
+        opcode = OP_FRAME_RAW
+        payload += pixels
+    return send_binary(opcode, payload, FLAG_NO_REPLY if stream else 0)
 
 
 def clear_sign():
@@ -69,60 +216,170 @@ def set(text, x=0, y=10, color=(255, 255, 0), font="6x10"):
 
 
 
-def execute_scheduled_item(schedule_id, name, **kwargs):
+def build_scene_config(template_data, name):
     """
-    Execute a scheduled item. This function is called by the scheduler.
+    Build a scene in the text SET format from a template payload.
+    Args:
+        template_data (dict): Parsed template payload with an 'items' list
+        name (str): Text used for items without content
+    Returns:
+        str: Scene config, e.g. "STATIC;Hi;0;10;(255,255,0);6x10;END;"
+    """
+    config = ""
+    for item in template_data.get('items', []):
+        # ';' separates fields, and a newline would end the command
+        text = str(item.get('content', name)).replace(';', ',').replace('\n', ' ')
+        color = tuple(item.get('color', [255, 255, 0]))
+        font = item.get('font', '6x10')
+        y = item.get('y', 10)
+        # Items with a key can be updated in place later with patch_item()
+        key = f"#{item['key']}" if item.get('key') else ""
+        if item.get('type') == 'static':
+            x = item.get('x', 0)
+            config += f"STATIC{key};{text};{x};{y};({color[0]},{color[1]},{color[2]});{font};END;"
+        elif item.get('type') == 'scrolling':
+            speed = item.get('speed', 70)
+            config += f"SCROLL{key};{text};{y};({color[0]},{color[1]},{color[2]});{speed};{font};END;"
+    return config
+
+
+def schedule_item(schedule_id):
+    """
+    Hand a scheduled item to the daemon's scheduler, which fires it on its
+    own from then on, whether or not this app is running. The entry names
+    the item's template, which the daemon activates when it fires.
     Args:
         schedule_id (int): ID of the scheduled item
-        label (str): Label of the scheduled item
-        **kwargs: Additional parameters for the scheduled action
+    Returns:
+        str: Response from the LED sign server
     """
-    
-    #try:
-    print(f"Executing scheduled item {schedule_id} with name '{name}'")
     scheduled_item = get_scheduled_item(schedule_id)
+    if not scheduled_item:
+        return f"ERROR: schedule {schedule_id} not found"
+
+    # Make sure the daemon has the template the entry refers to
+    template_id = scheduled_item['template_id']
+    response = upload_template(template_id)
+    if response.startswith("ERR"):
+        return response
+
+    when = scheduled_item['scheduled_datetime']
+    if scheduled_item['is_recurring']:
+        # Recurring items store the time of day; weekdays use 0=Monday like the daemon
+        weekdays = scheduled_item['recurring_weekdays'] or "0,1,2,3,4,5,6"
+        time_of_day = when if len(when) <= 5 else datetime.fromisoformat(when).strftime('%H:%M')
+        spec = f"WEEKLY {weekdays.replace(' ', '')} {time_of_day}"
+    else:
+        spec = f"ONCE {int(datetime.fromisoformat(when).timestamp())}"
 
-    # Get template data
-    template = get_template(scheduled_item['template_id'])
+    return send_command(f"SCHEDULE ADD {schedule_id} {spec} TEMPLATE {template_id}")
 
-    if not template:
-        print(f"Template not found for schedule {schedule_id}")
-        return
 
-    
-    template_data = parseJSONPayload(template['payload'])
+def unschedule_item(schedule_id):
+    """Remove a scheduled item from the daemon's scheduler."""
+    return send_command(f"SCHEDULE DEL {schedule_id}")
+
+
+def sync_schedule():
+    """Replace the daemon's schedule with the scheduled items in the database."""
+    response = send_command("SCHEDULE CLEAR")
+    if response.startswith("ERR"):
+        return response
+    for item in get_all_scheduled_items():
+        response = schedule_item(item['id'])
+        print(f"Scheduled item {item['id']} ({item['name']}): {response}")
+    return "OK"
+
 
+def upload_template(template_id):
+    """
+    Store a template in the daemon, which parses and prepares it once so
+    activating it later costs no parsing.
+    Args:
+        template_id (int): ID of the template
+    Returns:
+        str: Response from the LED sign server
+    """
+    template = get_template(template_id)
+    template_data = parseJSONPayload(template['payload']) if template else None
     if not template_data:
-        print(f"Invalid payload for template {template['id']}")
-        return
+        return f"ERROR: no valid template {template_id}"
+    config = build_scene_config(template_data, template['name'])
+    return send_command(f"TEMPLATE {template_id} {config}")
 
-    sign_name = template_data.get('name', 'LED Sign template?')
-    sign_config = template_data.get('items', {})
-    command = "SET"
 
-    for item in sign_config:
-        print(f"Processing item: {item}")
-        if item.get('type') == 'static':
-            text = item.get('content', name)
-            x = item.get('x', 0)
-            y = item.get('y', 10)
-            color = tuple(item.get('color', [255, 255, 0]))
-            font = item.get('font', '6x10')
-            print(f"Setting text on LED sign: '{text}' at ({x},{y}) with color {color} and font {font}")
+def remove_uploaded_template(template_id):
+    """Drop a template from the daemon."""
+    return send_command(f"TEMPLATE DEL {template_id}")
 
-            command += f"STATIC;{text};{x};{y};({color[0]},{color[1]},{color[2]});{font};END;"
 
-        if item.get('type') == 'scrolling':
-            text = item.get('content', name)
-            x = item.get('x', 0)
-            y = item.get('y', 10)
-            color = tuple(item.get('color', [255, 255, 0]))
-            speed = item.get('speed', 70)
-            font = item.get('font', '6x10')
-            print(f"Setting scrolling text on LED sign: '{text}' at ({x},{y}) with color {color}, speed {speed}, and font {font}")
-            command += f"SCROLL;{text};{y};({color[0]},{color[1]},{color[2]});{speed};{font};END;"
+def activate_template(template_id):
+    """Show a template previously stored with upload_template()."""
+    return send_command(f"ACTIVATE {template_id}")
+
 
-    response = send_command(command)
-    print(f"LED sign response: {response}")
+def sync_templates():
+    """Upload every template in the database to the daemon."""
+    result = "OK"
+    for template in get_all_templates():
+        response = upload_template(template['id'])
+        if response.startswith("ERR"):
+            print(f"Template {template['id']} ({template['name']}): {response}")
+            result = response
+    return result
 
 
+def play_playlist(entries):
+    """
+    Replace the daemon's playlist and start rotating through it. The daemon
+    switches scenes itself, with the next one prepared ahead of time.
+    Args:
+        entries (list): (template_id, seconds, fade_seconds) tuples; a fade
+            of 0 cuts straight to the scene
+    Returns:
+        str: Response from the LED sign server
+    """
+    response = send_command("PLAYLIST CLEAR")
+    if response.startswith("ERR"):
+        return response
+    for template_id, seconds, fade_seconds in entries:
+        template = get_template(template_id)
+        template_data = parseJSONPayload(template['payload']) if template else None
+        if not template_data:
+            return f"ERROR: no valid template {template_id}"
+        config = build_scene_config(template_data, template['name'])
+        response = send_command(f"PLAYLIST ADD {int(seconds * 1000)} {int(fade_seconds * 1000)} {config}")
+        if response.startswith("ERR"):
+            return response
+    return send_command("PLAYLIST START")
+
+
+def stop_playlist():
+    """Stop rotating; the scene on display stays up."""
+    return send_command("PLAYLIST STOP")
+
+
+def patch_item(key, text=None, color=None, x=None, y=None):
+    """
+    Update one keyed item of the scene on display without resending the
+    scene; other items, including scrolling text, carry on undisturbed.
+    Args:
+        key (str): Key the item was given, e.g. "queue" for STATIC#queue
+        text (str): New text
+        color (tuple): New (r, g, b) color
+        x (int): New x position (static text only)
+        y (int): New y position
+    Returns:
+        str: Response from the LED sign server
+    """
+    fields = []
+    if text is not None:
+        fields.append(f"text={str(text).replace(';', ',').replace(chr(10), ' ')}")
+    if color is not None:
+        r, g, b = color
+        fields.append(f"color=({r},{g},{b})")
+    if x is not None:
+        fields.append(f"x={int(x)}")
+    if y is not None:
+        fields.append(f"y={int(y)}")
+    return send_command(f"PATCH {key};{';'.join(fields)}")
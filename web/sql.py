@@ -68,19 +68,6 @@ def init_db(conn):
         );
         """
     )
-    
-
-    # Store the last run job for graceful recovery upon restarting
-    conn.execute(
-        """
-        CREATE TABLE IF NOT EXISTS last_run (
-            id INTEGER PRIMARY KEY CHECK (id = 1),
-            last_run_datetime TEXT,
-            schedule_id INTEGER,
-            FOREIGN KEY (schedule_id) REFERENCES schedule(id) ON DELETE SET NULL
-        );
-        """
-    )
 
 
 @with_conn
@@ -157,6 +144,21 @@ def get_all_scheduled_items(conn):
     return cursor.fetchall()
 
 
+@with_conn
+def get_scheduled_items_by_template(conn, template_id):
+    """
+    Get the scheduled items that show a template.
+    
+    Args:
+        template_id (int): ID of the template
+    
+    Returns:
+        list[sqlite3.Row]: Scheduled items using the template
+    """
+    cursor = conn.execute("SELECT * FROM schedule WHERE template_id = ?", (template_id,))
+    return cursor.fetchall()
+
+
 @with_conn
 def get_scheduled_items_by_datetime(conn, start_datetime, end_datetime=None):
     """
@@ -384,46 +386,6 @@ def get_weekday_names(weekdays_str):
     except (ValueError, IndexError):
         return weekdays_str
 
-def get_last_run():
-    """
-    Get the last run scheduled item.
-    
-    Returns:
-        dict or None: Dictionary with 'last_run_datetime' and 'schedule_id', or None if not set
-    """
-    conn = sqlite3.connect(DB_PATH, timeout=10, isolation_level=None)
-    conn.row_factory = sqlite3.Row
-    cursor = conn.execute("SELECT * FROM last_run WHERE id = 1")
-    row = cursor.fetchone()
-    conn.close()
-    
-    if row:
-        return {
-            'last_run_datetime': row['last_run_datetime'],
-            'schedule_id': row['schedule_id']
-        }
-    return None
-
-
-def recover_scheduled_jobs():
-    """Rerun the last job or the next job if ready."""
-    from sign import execute_scheduled_item
-        
-    last_run = get_last_run()
-    if last_run:
-        last_run_time = datetime.fromisoformat(last_run['last_run_datetime'])
-        schedule_id = last_run['schedule_id']
-        schedule = get_scheduled_item(schedule_id)
-        if schedule:
-            # Re-execute the last job
-            print(f"Re-executing last job: {schedule['name']}")
-            execute_scheduled_item(schedule_id=schedule_id, name=schedule['name'])
-            return
-
-
-
-
-
 def debug_schedule():
     """Insert test scheduled items for debugging purposes."""
     from datetime import timedelta